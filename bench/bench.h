@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Each benchmark program times its cases and prints one line for each.
+// `make bench` builds them with optimizations and runs them in turn.
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Keeps the compiler from optimizing away a result that isn't used.
+static volatile uint64_t bench_sink;
+
+#define BENCH_REPORT(name, ...)              \
+    do {                                     \
+        printf("  %-36s ", name);            \
+        printf(__VA_ARGS__);                 \
+        putchar('\n');                       \
+    } while (0)
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "column.h"
+#include "history.h"
+#include "splitsbin.h"
+#include "splitter.h"
+
+#define VALUES   (4 << 20)
+#define PATH     "column_bench.splits"
+#define SEGMENTS 20
+#define ATTEMPTS 100'000
+
+// splitmix64
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// A segment's times across attempts: around a minute, give or take a
+// few seconds, in steps of `unit`, with every `none`th one missing.
+static void fill(Duration* values, Duration unit, int none) {
+    uint64_t state = unit;
+    for (int i = 0; i < VALUES; ++i) {
+        Duration t = NSEC_PER_MIN + (Duration)(next_random(&state) % (5 * NSEC_PER_SEC));
+        values[i] = none && i % none == 0 ? DURATION_NONE : t / unit * unit;
+    }
+}
+
+static void bench_column(const char* name, Duration unit, int none) {
+    Duration* values = malloc(sizeof(Duration) * VALUES);
+    Duration* decoded = malloc(sizeof(Duration) * VALUES);
+    uint8_t* encoded = malloc(column_encoded_bound(VALUES));
+    fill(values, unit, none);
+
+    double t = bench_now();
+    size_t size = column_encode(values, VALUES, encoded);
+    double encoding = bench_now() - t;
+    t = bench_now();
+    bool ok = column_decode(encoded, size, decoded, VALUES);
+    double decoding = bench_now() - t;
+    ok = ok && memcmp(values, decoded, sizeof(Duration) * VALUES) == 0;
+
+    BENCH_REPORT(name, "%.1f B/value, encode %.0f Mv/s, decode %.0f Mv/s%s", (double)size / VALUES,
+                 VALUES / encoding / 1e6, VALUES / decoding / 1e6, ok ? "" : " (MISMATCH)");
+    free(values);
+    free(decoded);
+    free(encoded);
+}
+
+// Whole files: what each attempt costs on disk, and loading it back.
+static void bench_file(void) {
+    SplitsMap m = {.splits = splits_create(), .game = STR("Game"), .category = STR("Any%")};
+    for (int i = 0; i < SEGMENTS; ++i)
+        splits_append(&m.splits, split_create(STR("segment"), (Duration)(i + 1) * NSEC_PER_MIN));
+    History h;
+    history_init(&h, SEGMENTS);
+    uint64_t state = 1;
+    Duration times[SEGMENTS];
+    for (int a = 0; a < ATTEMPTS; ++a) {
+        Duration t = 0;
+        for (int i = 0; i < SEGMENTS; ++i) {
+            // LiveSplit's 100 ns ticks.
+            t += (NSEC_PER_MIN + (Duration)(next_random(&state) % (5 * NSEC_PER_SEC))) / 100 * 100;
+            times[i] = t;
+        }
+        history_add(&h, times, SEGMENTS - a % 3, 0);
+    }
+
+    double t = bench_now();
+    bool saved = splits_save_binary(STR(PATH), &m, &h);
+    double saving = bench_now() - t;
+    SplitsMap loaded;
+    History loaded_history;
+    t = bench_now();
+    bool ok = saved && splits_map(&loaded, STR(PATH)) && splits_map_history(&loaded, &loaded_history);
+    double loading = bench_now() - t;
+    if (ok) {
+        BENCH_REPORT("file", "%.0f B/attempt (raw %zu), save %.0f ms, load %.0f ms",
+                     (double)loaded.size / ATTEMPTS, sizeof(Attempt) + SEGMENTS * sizeof(Duration), saving * 1e3,
+                     loading * 1e3);
+        history_free(&loaded_history);
+        splits_release(&loaded);
+    } else {
+        BENCH_REPORT("file", "couldn't save or load " PATH);
+    }
+    unlink(PATH);
+    history_free(&h);
+    splits_release(&m);
+}
+
+int main(void) {
+    printf("column (%d values; %d segments x %d attempts):\n", VALUES, SEGMENTS, ATTEMPTS);
+    bench_column("100 ns ticks (LiveSplit)", 100, 0);
+    bench_column("us precision", NSEC_PER_USEC, 0);
+    bench_column("ns noise", 1, 0);
+    bench_column("ms with 1/7 missing", NSEC_PER_MSEC, 7);
+
+    Duration* values = malloc(sizeof(Duration) * VALUES);
+    Duration* copy = malloc(sizeof(Duration) * VALUES);
+    fill(values, 1, 0);
+    // The best of a few, once the pages are in.
+    double copying = 1e9;
+    for (int n = 0; n < 5; ++n) {
+        double t = bench_now();
+        memcpy(copy, values, sizeof(Duration) * VALUES);
+        t = bench_now() - t;
+        copying = t < copying ? t : copying;
+    }
+    bench_sink = copy[VALUES - 1];
+    BENCH_REPORT("raw memcpy", "8.0 B/value, %.0f Mv/s", VALUES / copying / 1e6);
+    free(values);
+    free(copy);
+
+    bench_file();
+    return 0;
+}
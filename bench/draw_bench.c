@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <raylib.h>
+
+#include "bench.h"
+#include "comparison.h"
+#include "history.h"
+#include "splitter.h"
+#include "stats.h"
+
+#define SPLITS 20
+#define FRAMES 1200 // 20 s at 60 fps
+#define FRAME  (NSEC_PER_SEC / 60)
+
+// splitter_draw's calls into raylib are counted by wrapping them at link
+// time (see the Makefile). With a display they go through to raylib.
+// Without one nothing is drawn and the wrappers stand in for the window,
+// so only the calls are counted, not how raylib batches them for the GPU.
+static bool headless;
+
+static struct {
+    int64_t rectangles;
+    int64_t texts;
+    int64_t glyphs;  // one quad each
+    int64_t blits;   // of the cached rows
+    int64_t targets; // switches into a render texture
+} calls;
+
+void __real_DrawRectangle(int x, int y, int width, int height, Color color);
+void __real_DrawText(const char* text, int x, int y, int size, Color color);
+void __real_DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint);
+void __real_BeginTextureMode(RenderTexture2D target);
+void __real_EndTextureMode(void);
+void __real_ClearBackground(Color color);
+RenderTexture2D __real_LoadRenderTexture(int width, int height);
+void __real_UnloadRenderTexture(RenderTexture2D target);
+int __real_MeasureText(const char* text, int size);
+Vector2 __real_MeasureTextEx(Font font, const char* text, float size, float spacing);
+Font __real_GetFontDefault(void);
+int __real_GetScreenWidth(void);
+int __real_GetScreenHeight(void);
+float __real_GetFrameTime(void);
+
+void __wrap_DrawRectangle(int x, int y, int width, int height, Color color) {
+    ++calls.rectangles;
+    if (!headless)
+        __real_DrawRectangle(x, y, width, height, color);
+}
+
+void __wrap_DrawText(const char* text, int x, int y, int size, Color color) {
+    ++calls.texts;
+    for (const char* c = text; *c; ++c)
+        calls.glyphs += *c != ' ';
+    if (!headless)
+        __real_DrawText(text, x, y, size, color);
+}
+
+void __wrap_DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint) {
+    ++calls.blits;
+    if (!headless)
+        __real_DrawTextureRec(texture, source, position, tint);
+}
+
+void __wrap_BeginTextureMode(RenderTexture2D target) {
+    ++calls.targets;
+    if (!headless)
+        __real_BeginTextureMode(target);
+}
+
+void __wrap_EndTextureMode(void) {
+    if (!headless)
+        __real_EndTextureMode();
+}
+
+void __wrap_ClearBackground(Color color) {
+    if (!headless)
+        __real_ClearBackground(color);
+}
+
+RenderTexture2D __wrap_LoadRenderTexture(int width, int height) {
+    if (!headless)
+        return __real_LoadRenderTexture(width, height);
+    return (RenderTexture2D){.id = 1, .texture = {.id = 1, .width = width, .height = height}};
+}
+
+void __wrap_UnloadRenderTexture(RenderTexture2D target) {
+    if (!headless)
+        __real_UnloadRenderTexture(target);
+}
+
+// Headless, text is measured as if every glyph were half as wide as it's tall.
+int __wrap_MeasureText(const char* text, int size) {
+    return headless ? (int)strlen(text) * size / 2 : __real_MeasureText(text, size);
+}
+
+Vector2 __wrap_MeasureTextEx(Font font, const char* text, float size, float spacing) {
+    if (!headless)
+        return __real_MeasureTextEx(font, text, size, spacing);
+    return (Vector2){strlen(text) * size / 2, size};
+}
+
+Font __wrap_GetFontDefault(void) {
+    return headless ? (Font){0} : __real_GetFontDefault();
+}
+
+int __wrap_GetScreenWidth(void) {
+    return headless ? 400 : __real_GetScreenWidth();
+}
+
+int __wrap_GetScreenHeight(void) {
+    return headless ? 800 : __real_GetScreenHeight();
+}
+
+float __wrap_GetFrameTime(void) {
+    return headless ? 1.0f / 60 : __real_GetFrameTime();
+}
+
+// A run through every split, a split every second, against a PB, drawn
+// for FRAMES frames with or without the draw cache.
+static void run(const char* name, bool cached) {
+    SplitterState ss = {.layout = LAYOUT_DEFAULT, .splits = splits_create(), .compare_stat = -1};
+    char split_name[32];
+    for (int i = 0; i < SPLITS; ++i) {
+        snprintf(split_name, sizeof(split_name), "Split %d", i + 1);
+        splits_append(&ss.splits, split_create(STR(split_name), 0));
+    }
+    history_init(&ss.history, SPLITS);
+    Duration times[SPLITS];
+    for (int i = 0; i < SPLITS; ++i)
+        times[i] = (Duration)(i + 1) * (NSEC_PER_SEC + 3 * FRAME);
+    history_add(&ss.history, times, SPLITS, 0);
+    splitter_load_comparisons(&ss);
+    DrawCache cache = {0};
+    ss.draw_cache = cached ? &cache : NULL;
+
+    memset(&calls, 0, sizeof(calls));
+    splitter_start(&ss, 0);
+    double t = bench_now();
+    for (int frame = 1; frame <= FRAMES; ++frame) {
+        Duration time = frame * FRAME;
+        if (frame % 60 == 0)
+            splitter_split(&ss, time);
+        ss.timer.cur = time;
+        if (!headless) {
+            BeginDrawing();
+            ClearBackground(BLACK);
+        }
+        splitter_draw(ss);
+        if (!headless)
+            EndDrawing();
+    }
+    t = bench_now() - t;
+
+    BENCH_REPORT(name, "%.1f rects, %.1f texts (%.0f glyphs), %.2f blits, %.3f redraws per frame; %.0f us",
+                 (double)calls.rectangles / FRAMES, (double)calls.texts / FRAMES, (double)calls.glyphs / FRAMES,
+                 (double)calls.blits / FRAMES, (double)calls.targets / FRAMES, t / FRAMES * 1e6);
+    draw_cache_free(&cache);
+    comparisons_free(&ss.comparisons);
+    segment_stats_free(&ss.stats);
+    history_free(&ss.history);
+    splits_free(ss.splits);
+}
+
+int main(void) {
+    headless = !getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY");
+    printf("draw (%d splits, %d frames%s):\n", SPLITS, FRAMES, headless ? ", no display: calls only" : "");
+    if (!headless) {
+        SetTraceLogLevel(LOG_WARNING);
+        InitWindow(400, 800, "draw_bench");
+    }
+    run("uncached", false);
+    run("cached", true);
+    if (!headless)
+        CloseWindow();
+    return 0;
+}
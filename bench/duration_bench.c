@@ -0,0 +1,36 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "duration.h"
+
+#define COUNT 4'000'000
+
+// How times were formatted before duration_format, one field at a time.
+static int format_sprintf(char* out, Duration d) {
+    const char* sign = d < 0 ? "-" : "";
+    if (d < 0)
+        d = -d;
+    return sprintf(out, "%s%d:%02d.%02d", sign, (int)duration_minutes(d), (int)duration_seconds(d),
+                   (int)duration_centiseconds(d));
+}
+
+int main(void) {
+    printf("duration:\n");
+    char text[DURATION_TEXT_SIZE];
+    uint64_t sum = 0;
+    // A split time every 7.3 s or so, as a timer would show them.
+    double start = bench_now();
+    for (int i = 0; i < COUNT; ++i)
+        sum += duration_format(text, (Duration)i * 7'300'001, 2, 0);
+    double formatted = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < COUNT; ++i)
+        sum += format_sprintf(text, (Duration)i * 7'300'001);
+    double printed = bench_now() - start;
+    bench_sink = sum;
+
+    BENCH_REPORT("duration_format", "%.1f ns", formatted / COUNT * 1e9);
+    BENCH_REPORT("sprintf of each field", "%.1f ns", printed / COUNT * 1e9);
+    return 0;
+}
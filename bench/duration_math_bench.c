@@ -0,0 +1,65 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "duration.h"
+
+#define COUNT 4'000'000
+
+// The timespec and double arithmetic that Duration replaced.
+static struct timespec old_delta(struct timespec a, struct timespec b) {
+    return (struct timespec){
+        .tv_sec = labs(a.tv_sec - b.tv_sec),
+        .tv_nsec = labs(a.tv_nsec - b.tv_nsec)
+    };
+}
+
+static double old_seconds(struct timespec ts) {
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000 + (double)ts.tv_nsec / 10000000000;
+}
+
+static uint64_t old_minutes(struct timespec ts) {
+    return (uint64_t)(ts.tv_sec / 60);
+}
+
+// Clock readings of a run started at `base`, as the timer would see them.
+static Duration reading(Duration base, int i) {
+    return base + (Duration)i * 16'666'667 + i % 7;
+}
+
+int main(void) {
+    printf("duration_math:\n");
+    Duration base = 12'345 * NSEC_PER_SEC + 987'654'321;
+    struct timespec start = duration_to_timespec(base);
+    Duration start_d = base;
+
+    // The elapsed time and its minutes and seconds, as each frame shows.
+    uint64_t sum = 0;
+    int wrong = 0;
+    double t = bench_now();
+    for (int i = 0; i < COUNT; ++i) {
+        struct timespec elapsed = old_delta(duration_to_timespec(reading(base, i)), start);
+        sum += old_minutes(elapsed) + (uint64_t)(fmod(old_seconds(elapsed), 60) * 100);
+    }
+    double old_time = bench_now() - t;
+
+    t = bench_now();
+    for (int i = 0; i < COUNT; ++i) {
+        Duration elapsed = reading(base, i) - start_d;
+        sum += duration_minutes(elapsed) + duration_seconds(elapsed) * 100 + duration_centiseconds(elapsed);
+    }
+    double new_time = bench_now() - t;
+    bench_sink = sum;
+
+    // How often the old delta was wrong: whenever the nanoseconds borrow.
+    for (int i = 0; i < COUNT; ++i) {
+        struct timespec elapsed = old_delta(duration_to_timespec(reading(base, i)), start);
+        wrong += duration_from_timespec(elapsed) != reading(base, i) - start_d;
+    }
+
+    BENCH_REPORT("timespec delta, doubles and fmod", "%.1f ns", old_time / COUNT * 1e9);
+    BENCH_REPORT("Duration subtraction and division", "%.1f ns", new_time / COUNT * 1e9);
+    BENCH_REPORT("timespec deltas that were wrong", "%.1f%%", 100.0 * wrong / COUNT);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "history.h"
+#include "lss.h"
+#include "splitter.h"
+
+#define PATH     "lss_bench.lss"
+#define ATTEMPTS 20'000
+#define SEGMENTS 200
+
+// A long history as LiveSplit writes it: attempts reach about half of
+// the segments on average, and times have 100 ns ticks.
+static void write_lss(void) {
+    FILE* f = fopen(PATH, "wb");
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Run version=\"1.7.0\">\n"
+               "  <GameName>Game</GameName>\n  <CategoryName>Any%%</CategoryName>\n  <AttemptHistory>\n");
+    for (int a = 1; a <= ATTEMPTS; ++a)
+        fprintf(f, "    <Attempt id=\"%d\" started=\"01/01/2024 00:00:00\" isStartedSynced=\"True\" "
+                   "ended=\"01/01/2024 00:30:00\" isEndedSynced=\"True\" />\n", a);
+    fprintf(f, "  </AttemptHistory>\n  <Segments>\n");
+    for (int i = 0; i < SEGMENTS; ++i) {
+        fprintf(f, "    <Segment>\n      <Name>Segment %d</Name>\n      <Icon />\n      <SplitTimes>\n"
+                   "        <SplitTime name=\"Personal Best\">\n          <RealTime>00:%02d:%02d.1234567</RealTime>\n"
+                   "        </SplitTime>\n      </SplitTimes>\n      <BestSegmentTime>\n"
+                   "        <RealTime>00:00:08.7654321</RealTime>\n      </BestSegmentTime>\n      <SegmentHistory>\n",
+                i, i * 10 / 60 % 60, i * 10 % 60);
+        for (int a = 1; a <= ATTEMPTS; ++a) {
+            if (i > a * 7919 % SEGMENTS + 10)
+                continue;
+            fprintf(f, "        <Time id=\"%d\">\n          <RealTime>00:00:%02d.%07d</RealTime>\n"
+                       "          <GameTime>00:00:%02d.%07d</GameTime>\n        </Time>\n",
+                    a, 8 + a % 5, a * 31 % 10'000'000, 8 + a % 4, a * 17 % 10'000'000);
+        }
+        fprintf(f, "      </SegmentHistory>\n    </Segment>\n");
+    }
+    fprintf(f, "  </Segments>\n</Run>\n");
+    fclose(f);
+}
+
+int main(void) {
+    printf("lss_import (%d attempts, %d segments):\n", ATTEMPTS, SEGMENTS);
+    write_lss();
+
+    // The least any import could do: read the file and find its lines.
+    double t = bench_now();
+    FILE* f = fopen(PATH, "rb");
+    size_t cap = 1 << 18;
+    char* buf = malloc(cap);
+    size_t n;
+    size_t size = 0;
+    uint64_t lines = 0;
+    while ((n = fread(buf, 1, cap, f)) > 0) {
+        size += n;
+        for (char* p = buf; (p = memchr(p, '\n', buf + n - p)); ++p)
+            ++lines;
+    }
+    fclose(f);
+    free(buf);
+    double scanned = bench_now() - t;
+    bench_sink = lines;
+
+    t = bench_now();
+    SplitsMap map;
+    History h;
+    bool ok = lss_import(STR(PATH), &map, &h);
+    double imported = bench_now() - t;
+    unlink(PATH);
+    if (!ok) {
+        printf("  couldn't import " PATH "\n");
+        return 1;
+    }
+    int64_t times = 0;
+    for (int i = 0; i < h.segment_count; ++i)
+        for (int a = 0; a < h.attempt_count; ++a)
+            times += history_segment(&h, i, a) != DURATION_NONE;
+
+    BENCH_REPORT("lss_import", "%.0f ms, %.0f MB, %" PRId64 " times", imported * 1e3, size / 1e6, times);
+    BENCH_REPORT("fread and memchr", "%.0f ms", scanned * 1e3);
+    history_free(&h);
+    splits_release(&map);
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <sched.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "clock.h"
+#include "comparison.h"
+#include "history.h"
+#include "journal.h"
+#include "splitter.h"
+#include "stats.h"
+
+#define PATH   "recover_bench.journal"
+#define SPLITS 20
+#define ROUNDS 30'000 // of a pause, a resume, a split and an undo
+#define RUNS   5
+
+static void append(Journal* j, JournalEventType type, int index, Duration time) {
+    // Appending this fast can outrun the thread that extends the file.
+    while (!journal_append(j, type, index, time))
+        sched_yield();
+}
+
+// A run in progress that an hour of pausing, splitting and undoing left
+// with more than 100k records.
+static void write_journal(void) {
+    unlink(PATH);
+    Journal j;
+    journal_open(&j, STR(PATH));
+    j.header->clock = ClockMonotonic;
+    Duration time = clock_now() - NSEC_PER_HOUR;
+    append(&j, JournalStart, 0, time);
+    for (int n = 0; n < ROUNDS; ++n) {
+        int index = n % (SPLITS - 1);
+        append(&j, JournalPause, index, time += 20 * NSEC_PER_MSEC);
+        append(&j, JournalResume, index, time += 20 * NSEC_PER_MSEC);
+        append(&j, JournalSplit, index, time += 20 * NSEC_PER_MSEC);
+        append(&j, JournalUndo, index + 1, time += 20 * NSEC_PER_MSEC);
+    }
+    journal_close(&j);
+}
+
+int main(void) {
+    clock_select(ClockMonotonic);
+    write_journal();
+
+    double open_best = 1e9;
+    double recover_best = 1e9;
+    size_t count = 0;
+    bool recovered = true;
+    for (int r = 0; r < RUNS; ++r) {
+        SplitterState ss = {.splits = splits_create(), .compare_stat = -1};
+        for (int i = 0; i < SPLITS; ++i)
+            splits_append(&ss.splits, split_create(STR("split"), 0));
+        history_init(&ss.history, SPLITS);
+        splitter_load_comparisons(&ss);
+
+        double t = bench_now();
+        Journal j;
+        journal_open(&j, STR(PATH));
+        double opened = bench_now() - t;
+        count = journal_count(&j);
+        ss.journal = &j;
+        t = bench_now();
+        recovered = recovered && splitter_recover(&ss);
+        double replayed = bench_now() - t;
+        open_best = opened < open_best ? opened : open_best;
+        recover_best = replayed < recover_best ? replayed : recover_best;
+
+        journal_close(&j);
+        timer_free(&ss.timer);
+        comparisons_free(&ss.comparisons);
+        segment_stats_free(&ss.stats);
+        history_free(&ss.history);
+        splits_free(ss.splits);
+    }
+    unlink(PATH);
+
+    printf("recover (%zu records, best of %d):\n", count, RUNS);
+    BENCH_REPORT("journal_open", "%.2f ms", open_best * 1e3);
+    BENCH_REPORT("splitter_recover", "%.2f ms%s", recover_best * 1e3, recovered ? "" : " (NOT RECOVERED)");
+    return !recovered;
+}
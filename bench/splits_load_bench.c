@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fiesta/str.h>
+
+#include "bench.h"
+#include "splitter.h"
+
+#define PATH  "splits_load_bench.splits"
+#define LINES 1'000'000
+
+// The loader that the streaming parser replaced, redone without fiesta,
+// whose str_arr crashes past a few dozen lines in this build: a line at
+// a time, read one fread() per byte as file_read_u8() does, then split
+// on spaces into a copy of each part, so names can't have any.
+static Splits old_splits_load(str filename) {
+    FILE* f = fopen(filename.data, "rb");
+    Splits splits = splits_create();
+    char line[128];
+    int len = 0;
+    char c;
+    bool more = true;
+    while (more) {
+        more = fread(&c, 1, 1, f) == 1;
+        if (more && c != '\n') {
+            if (len < (int)sizeof(line) - 1)
+                line[len++] = c;
+            continue;
+        }
+        line[len] = '\0';
+        char* parts[3] = {0};
+        int count = 0;
+        for (char* p = line; count < 3 && *p; ++count) {
+            char* space = strchr(p, ' ');
+            size_t n = space ? (size_t)(space - p) : strlen(p);
+            parts[count] = malloc(n + 1);
+            memcpy(parts[count], p, n);
+            parts[count][n] = '\0';
+            p += space ? n + 1 : n;
+        }
+        if (count == 3) {
+            Duration time = duration_from_parts(strtoll(parts[1], NULL, 10), strtoll(parts[2], NULL, 10));
+            splits_append(&splits, split_create(STR(parts[0]), time));
+        }
+        for (int i = 0; i < count; ++i)
+            free(parts[i]);
+        len = 0;
+    }
+    fclose(f);
+    return splits;
+}
+
+int main(void) {
+    printf("splits_load (%d lines):\n", LINES);
+    FILE* f = fopen(PATH, "w");
+    for (int i = 0; i < LINES; ++i)
+        fprintf(f, "split_%d %d %d\n", i, i / 10, (int)((int64_t)i * 7919 % 1'000'000'000));
+    fclose(f);
+
+    double t = bench_now();
+    SplitsMap m;
+    bool loaded = splits_load(&m, STR(PATH));
+    double streaming = bench_now() - t;
+    int count = loaded ? m.splits.len : 0;
+    if (loaded)
+        splits_unmap(&m);
+
+    t = bench_now();
+    Splits old = old_splits_load(STR(PATH));
+    double split_lines = bench_now() - t;
+    int old_count = old.len;
+    splits_free(old);
+    unlink(PATH);
+
+    BENCH_REPORT("streaming parse", "%.0f ms, %d splits", streaming * 1e3, count);
+    BENCH_REPORT("lines split on spaces", "%.0f ms, %d splits", split_lines * 1e3, old_count);
+    return count != LINES || old_count != LINES;
+}
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <raylib.h>
+
+#include "bench.h"
+#include "comparison.h"
+#include "history.h"
+#include "loader.h"
+#include "splitsbin.h"
+#include "splitter.h"
+#include "stats.h"
+
+#define PATH     "startup_bench.splits"
+#define SEGMENTS 20
+#define ATTEMPTS 100'000
+
+static void write_splits(void) {
+    SplitsMap m = {.splits = splits_create(), .game = STR("Game"), .category = STR("Any%")};
+    for (int i = 0; i < SEGMENTS; ++i)
+        splits_append(&m.splits, split_create(STR("segment"), (Duration)(i + 1) * NSEC_PER_MIN));
+    History h;
+    history_init(&h, SEGMENTS);
+    Duration times[SEGMENTS];
+    for (int a = 0; a < ATTEMPTS; ++a) {
+        for (int i = 0; i < SEGMENTS; ++i)
+            times[i] = (Duration)(i + 1) * NSEC_PER_MIN + (Duration)(a * 7919 % 5000) * NSEC_PER_MSEC;
+        history_add(&h, times, SEGMENTS - a % 3, 0);
+    }
+    splits_save_binary(STR(PATH), &m, &h);
+    history_free(&h);
+    splits_release(&m);
+}
+
+// Map the splits and draw them once, with the history loaded first (as
+// before it moved to the background) or not. Returns the time taken.
+static double first_frame(bool load_history) {
+    double t = GetTime();
+    SplitsMap map;
+    if (!splits_map(&map, STR(PATH)))
+        return -1;
+    SplitterState ss = {.layout = LAYOUT_DEFAULT, .splits = map.splits, .compare_stat = -1};
+    if (!load_history || !splits_map_history(&map, &ss.history))
+        history_init(&ss.history, map.splits.len);
+    splitter_load_comparisons(&ss);
+    BeginDrawing();
+    ClearBackground(BLACK);
+    splitter_draw(ss);
+    EndDrawing();
+    t = GetTime() - t;
+    comparisons_free(&ss.comparisons);
+    segment_stats_free(&ss.stats);
+    history_free(&ss.history);
+    splits_release(&map);
+    return t;
+}
+
+int main(void) {
+    printf("startup (%d segments x %d attempts):\n", SEGMENTS, ATTEMPTS);
+    write_splits();
+
+    // Without a window: when the splits can be shown, and when the
+    // history follows on the loader's thread.
+    double t = bench_now();
+    SplitsMap map;
+    if (!splits_map(&map, STR(PATH))) {
+        printf("  couldn't map " PATH "\n");
+        unlink(PATH);
+        return 1;
+    }
+    double mapped = bench_now() - t;
+    History h;
+    history_init(&h, map.splits.len);
+    HistoryLoader loader;
+    history_loader_start(&loader, &map);
+    int loaded = history_loader_poll(&loader, &h, true);
+    double history = bench_now() - t;
+    history_free(&h);
+    splits_release(&map);
+    BENCH_REPORT("splits ready", "%.2f ms", mapped * 1e3);
+    BENCH_REPORT("history loaded", "%.0f ms, %d attempts", history * 1e3, loaded);
+
+    // The first frame needs a window, so it's skipped without a display.
+    if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY")) {
+        BENCH_REPORT("first frame", "skipped: no display");
+    } else {
+        SetTraceLogLevel(LOG_WARNING);
+        InitWindow(400, 800, "startup_bench");
+        // GetTime() counts from InitWindow().
+        double window = GetTime();
+        double background = first_frame(false);
+        double waiting = first_frame(true);
+        CloseWindow();
+        BENCH_REPORT("first frame from InitWindow", "%.1f ms", (window + background) * 1e3);
+        BENCH_REPORT("  waiting for the history", "%.1f ms", (window + waiting) * 1e3);
+    }
+    unlink(PATH);
+    return 0;
+}
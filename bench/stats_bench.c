@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "history.h"
+#include "pool.h"
+#include "stats.h"
+
+#define SEGMENTS 200
+#define ATTEMPTS 50'000
+#define UPDATES  20
+
+// splitmix64
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+static void add_attempt(History* h, uint64_t* state) {
+    Duration times[SEGMENTS];
+    Duration t = 0;
+    for (int i = 0; i < SEGMENTS; ++i) {
+        // Distinct times, the worst case for tracking ranks.
+        t += 10 * NSEC_PER_SEC + (Duration)(next_random(state) % (5 * NSEC_PER_SEC));
+        times[i] = t;
+    }
+    history_add(h, times, SEGMENTS - h->attempt_count % 5, 0);
+}
+
+static int compare_durations(const void* a, const void* b) {
+    Duration x = *(const Duration*)a;
+    Duration y = *(const Duration*)b;
+    return (x > y) - (x < y);
+}
+
+// Recomputing the median the simple way: copy each column and sort it.
+static double sort_columns(History* h) {
+    Duration* column = malloc(sizeof(Duration) * h->attempt_count);
+    double t = bench_now();
+    uint64_t sum = 0;
+    for (int i = 0; i < h->segment_count; ++i) {
+        int n = 0;
+        for (int a = 0; a < h->attempt_count; ++a)
+            if (h->segments[i][a] != DURATION_NONE)
+                column[n++] = h->segments[i][a];
+        qsort(column, n, sizeof(Duration), compare_durations);
+        sum += n ? column[n / 2] : 0;
+    }
+    bench_sink = sum;
+    t = bench_now() - t;
+    free(column);
+    return t;
+}
+
+int main(void) {
+    printf("stats (%d attempts x %d segments):\n", ATTEMPTS, SEGMENTS);
+    History h;
+    history_init(&h, SEGMENTS);
+    uint64_t state = 1;
+    for (int a = 0; a < ATTEMPTS; ++a)
+        add_attempt(&h, &state);
+
+    Pool pool;
+    pool_init(&pool, 0);
+    SegmentStats s = {0};
+    double t = bench_now();
+    segment_stats_compute(&s, &h, NULL);
+    double single = bench_now() - t;
+    segment_stats_free(&s);
+    t = bench_now();
+    segment_stats_compute(&s, &h, &pool);
+    double pooled = bench_now() - t;
+
+    double total = 0;
+    double worst = 0;
+    for (int n = 0; n < UPDATES; ++n) {
+        add_attempt(&h, &state);
+        t = bench_now();
+        segment_stats_update(&s, &h, &pool);
+        t = bench_now() - t;
+        total += t;
+        worst = t > worst ? t : worst;
+    }
+    double sorted = sort_columns(&h);
+
+    BENCH_REPORT("compute, one thread", "%.0f ms", single * 1e3);
+    BENCH_REPORT("compute, pool", "%.0f ms, %d workers", pooled * 1e3, pool.thread_count);
+    BENCH_REPORT("update after an attempt", "%.2f ms, worst %.2f ms", total / UPDATES * 1e3, worst * 1e3);
+    BENCH_REPORT("sorting every column", "%.0f ms", sorted * 1e3);
+    segment_stats_free(&s);
+    pool_free(&pool);
+    history_free(&h);
+    return 0;
+}
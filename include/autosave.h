@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "history.h"
+#include "saver.h"
+#include "splitter.h"
+
+// Tracks what changed since the splits were last saved, so that saving
+// appends only the changed splits and the new attempts to the file's
+// update log instead of writing the whole file again.
+typedef struct Autosave {
+    uint64_t* dirty;    // bitset of splits changed since the last save
+    int split_count;
+    int saved_attempts; // attempts that are already in the file
+    bool full;          // the next save has to write the whole file
+    size_t body_size;   // of the file as last written whole
+    size_t log_size;    // of the updates appended since
+} Autosave;
+
+// Start tracking splits that are saved as they are (`saved`), or that
+// haven't been saved yet, in which case the first save is a whole one.
+void autosave_init(Autosave* a, int split_count, int attempt_count, size_t body_size, bool saved);
+void autosave_free(Autosave* a);
+void autosave_mark_split(Autosave* a, int index);
+// Write the whole file on the next save.
+void autosave_mark_all(Autosave* a);
+// Whether anything changed since the last save.
+bool autosave_pending(Autosave* a, History* history);
+bool autosave_split_dirty(Autosave* a, int index);
+// Append the attempts in `from` that haven't been saved yet to `to`, the
+// history as reloaded from the file. Returns how many were appended, or
+// -1 if the histories' segments don't line up.
+int autosave_carry_attempts(Autosave* a, History* from, History* to);
+// Queue a save of whatever changed. The whole file is written instead
+// if the update log would grow larger than the file itself.
+void autosave_flush(Autosave* a, Saver* saver, const SplitsMap* m, History* history);
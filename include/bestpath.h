@@ -0,0 +1,49 @@
+#pragma once
+
+#include "array.h"
+#include "duration.h"
+#include "history.h"
+
+// The best time for going from one split to a later one in a single
+// stretch: one segment, or several when the splits between were skipped.
+typedef struct {
+    int to;
+    Duration time;
+} Span;
+
+void span_free(Span s);
+_GENERATE_FUNCTION_PROTOTYPES(Span, span)
+
+// Sum of best when splits can be skipped: the history's best spans are
+// the edges of a DAG over the splits (0 is the start, segment_count the
+// end), and the sum of best is its shortest path from start to end.
+// Since edges only go forward, the shortest paths to the end are found
+// in one pass from the last split back, and a changed span only needs
+// the splits before it that lead into a changed path looked at again.
+typedef struct {
+    int segment_count;
+    Spans* spans;    // spans[split]: the spans starting from it
+    // remaining[split]: shortest time from it to the end, DURATION_NONE
+    // if the end can't be reached from it.
+    Duration* remaining;
+    // first_into[split]: the earliest split with a span into it (itself
+    // if there's none).
+    int* first_into;
+} BestPaths;
+
+// Build the DAG from every attempt in `h`.
+void best_paths_init(BestPaths* p, History* h);
+void best_paths_free(BestPaths* p);
+// Offer a time for going from split `from` to `to` (e.g. a segment of the
+// run in progress), which is kept if it's better than the best. Returns
+// whether it was.
+bool best_paths_offer(BestPaths* p, int from, int to, Duration time);
+// Set the best time from `from` to `to`, even if it's worse (or
+// DURATION_NONE), e.g. to take back an offer.
+void best_paths_set(BestPaths* p, int from, int to, Duration time);
+// Best time for the span from `from` to `to`, DURATION_NONE if none.
+Duration best_paths_span(const BestPaths* p, int from, int to);
+// Shortest time from `split` to the end, DURATION_NONE if unknown.
+static inline Duration best_paths_remaining(const BestPaths* p, int split) {
+    return p->remaining[split];
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "duration.h"
+
+typedef enum {
+    ClockMonotonic,
+    ClockMonotonicRaw,
+    ClockBoottime,
+    ClockTsc,     // rdtsc, calibrated against CLOCK_MONOTONIC
+    ClockVirtual, // only moves when told to, for deterministic tests
+    ClockSourceCount
+} ClockSource;
+
+typedef struct {
+    Duration read_cost;   // average time taken by one read
+    Duration granularity; // smallest observed non-zero step
+} ClockStats;
+
+// Read the selected clock. All timestamps given to the timer should
+// come from here so that they can be compared with each other.
+// Not thread-safe when the TSC source is selected.
+Duration    clock_now(void);
+// Select the clock source read by `clock_now`. Returns false (and
+// leaves the selection alone) if the source isn't available.
+bool        clock_select(ClockSource source);
+ClockSource clock_selected(void);
+// Check whether a clock source can be read on this machine.
+bool        clock_available(ClockSource source);
+const char* clock_name(ClockSource source);
+// Measure a clock source's read cost and granularity.
+ClockStats  clock_measure(ClockSource source);
+// Measure every available real clock source, log the results, and
+// select the cheapest one with at least microsecond granularity.
+ClockSource clock_select_best(void);
+
+// Set the virtual clock's current time.
+void clock_virtual_set(Duration time);
+// Move the virtual clock forward (or backward).
+void clock_virtual_advance(Duration d);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "duration.h"
+
+// Compressed encoding for a column of segment times. Values are split
+// into blocks of COLUMN_BLOCK, each of which can be decoded on its own:
+//   - a byte: the power of ten that every value in the block is a
+//     multiple of (times imported with coarser precision than
+//     nanoseconds shrink a lot), plus COLUMN_HAS_NONE
+//   - the size of the rest of the block, as a varint
+//   - if COLUMN_HAS_NONE, a bitmap of which values are DURATION_NONE
+//   - the other values (divided by the power of ten) as zig-zag varints:
+//     the first as is, the second as a delta, and the rest as deltas of
+//     deltas, since times across attempts change slowly.
+#define COLUMN_BLOCK    128
+#define COLUMN_HAS_NONE 0x80
+
+// Upper bound on the encoded size of `count` values.
+size_t column_encoded_bound(size_t count);
+// Encode `count` values into `out`, returning the encoded size.
+size_t column_encode(const Duration* values, size_t count, uint8_t* out);
+// Decode `count` values. Returns false if the data is truncated or
+// malformed, in which case `values` is left partially written.
+bool column_decode(const uint8_t* data, size_t size, Duration* values, size_t count);
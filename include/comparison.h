@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "bestpath.h"
+#include "duration.h"
+#include "history.h"
+
+// Personal best, best segments, sum of best and best possible time,
+// computed from the history once and then kept up to date as the run
+// in progress splits.
+typedef struct {
+    int segment_count;
+    // The personal best: the fastest completed attempt's split times,
+    // DURATION_NONE where unknown.
+    Duration pb;
+    Duration* pb_splits;
+    // Each segment's best time on its own, DURATION_NONE if it's never
+    // been done. Golds from the run in progress count right away.
+    Duration* best_segments;
+    // Best times between splits, including across skipped ones, for
+    // the sum of best.
+    BestPaths paths;
+    // The split times that deltas are against: the PB's, unless
+    // `comparisons_compare_to` was given others.
+    Duration* compare_splits;
+    bool compare_pb;
+    // The run in progress, which has reached `reached` splits.
+    int reached;
+    Duration* run_splits;
+    Duration* deltas;         // run split - compared split, DURATION_NONE without one
+    Duration* segment_deltas; // run segment - previous best, < 0 for a gold
+    Duration* prev_best;      // best segments before the run's splits, for undoing
+    // The last split plus the best time from it to the end (or the sum
+    // of best before the first split), DURATION_NONE if unknown.
+    Duration best_possible;
+} Comparisons;
+
+// Compute the comparisons from `history`. Without a completed attempt,
+// `fallback_splits` (cumulative, e.g. a file's split times) are the PB
+// if the last of them is set.
+void comparisons_init(Comparisons* c, History* history, const Duration* fallback_splits);
+void comparisons_free(Comparisons* c);
+// Sum of best: the fastest way to the end through the best segments and
+// spans of skipped ones, or DURATION_NONE if there's none.
+Duration comparisons_sum_of_best(const Comparisons* c);
+// Compare the run to `splits` (cumulative), or to the PB if NULL.
+void comparisons_compare_to(Comparisons* c, const Duration* splits);
+// The run reached its next split at `time` (cumulative).
+void comparisons_split(Comparisons* c, Duration time);
+// Take back the run's last split.
+void comparisons_undo(Comparisons* c);
+// End the run. If it reached the end faster than the PB, it's the new PB.
+void comparisons_reset(Comparisons* c);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// A signed count of nanoseconds. Used both for spans of time and for
+// clock readings (nanoseconds since the clock's epoch), so the difference
+// of two readings is just a subtraction.
+typedef int64_t Duration;
+
+#define NSEC_PER_USEC ((Duration)1'000)
+#define NSEC_PER_MSEC ((Duration)1'000'000)
+#define NSEC_PER_CSEC ((Duration)10'000'000)
+#define NSEC_PER_SEC  ((Duration)1'000'000'000)
+#define NSEC_PER_MIN  ((Duration)60'000'000'000)
+#define NSEC_PER_HOUR ((Duration)3'600'000'000'000)
+
+// Marks a time that hasn't happened (yet).
+#define DURATION_NONE INT64_MAX
+
+static inline Duration duration_from_timespec(struct timespec ts) {
+    return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static inline struct timespec duration_to_timespec(Duration d) {
+    return (struct timespec){
+        .tv_sec = d / NSEC_PER_SEC,
+        .tv_nsec = d % NSEC_PER_SEC
+    };
+}
+
+static inline Duration duration_from_parts(int64_t sec, int64_t nsec) {
+    return sec * NSEC_PER_SEC + nsec;
+}
+
+// Whole minutes, truncated toward zero.
+static inline int64_t duration_minutes(Duration d) {
+    return d / NSEC_PER_MIN;
+}
+
+// Whole seconds within the minute, truncated toward zero.
+static inline int64_t duration_seconds(Duration d) {
+    return d / NSEC_PER_SEC % 60;
+}
+
+// Hundredths of a second within the second, truncated toward zero.
+static inline int64_t duration_centiseconds(Duration d) {
+    return d / NSEC_PER_CSEC % 100;
+}
+
+// Enough for any `duration_format` output, with its NUL.
+#define DURATION_TEXT_SIZE 32
+
+typedef enum {
+    DurationSign  = 1 << 0, // start with '+' when not negative, as for deltas
+    DurationShort = 1 << 1, // leave out minutes when there are none, e.g. "+1.23"
+} DurationFormatFlags;
+
+// Format `d` as h:mm:ss.cc, or m:ss.cc under an hour, with `precision`
+// (0 to 9) digits of the fraction, truncated. Negative durations start
+// with '-'. Only integer operations are used, so e.g. 59.999 s is never
+// shown as "0:60.00". `out` must have room for DURATION_TEXT_SIZE
+// characters. Returns the length written, not counting the NUL.
+size_t duration_format(char* out, Duration d, int precision, unsigned flags);
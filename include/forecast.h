@@ -0,0 +1,48 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "duration.h"
+#include "history.h"
+#include "pool.h"
+
+// Estimates the chance that the run in progress beats the PB, by
+// simulating the rest of it many times: each remaining segment's time is
+// drawn from its distribution in the history (see sketch.h). This runs
+// on a background thread and its own pool, which leave a CPU free for
+// the render thread, in rounds of about a frame, and the estimate gets
+// more precise after each round until a new one is started. Starting
+// one only copies the sketches, and reading it never waits.
+#define FORECAST_QUANTILES 256                // times per segment drawn from
+#define FORECAST_ROUND     (NSEC_PER_SEC / 60)
+#define FORECAST_SAMPLES   (1 << 20)          // when to stop refining
+
+typedef struct ForecastJob ForecastJob;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stop;
+    Pool pool;
+    ForecastJob* pending; // started but not yet taken by the thread
+    unsigned started;     // counts started estimates, to abandon old ones
+    // The latest estimate, written by the thread under a sequence lock:
+    // `sequence` is odd while it's being written.
+    unsigned sequence;
+    unsigned estimate;    // the `started` count that it's for
+    uint64_t hits;
+    uint64_t samples;
+} Forecast;
+
+void forecast_init(Forecast* f);
+void forecast_free(Forecast* f);
+// Start estimating the chance of finishing under `pb` for a run that
+// reached `reached` splits at `time`, from the times in `h`. Nothing is
+// estimated without a PB, or if a remaining segment has no times yet.
+void forecast_start(Forecast* f, History* h, int reached, Duration time, Duration pb);
+// The latest estimate of the current run: the chance of a PB in [0, 1],
+// and how many simulated runs it's from. Returns false if there's none
+// (yet).
+bool forecast_read(Forecast* f, double* chance, uint64_t* samples);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "duration.h"
+#include "sketch.h"
+
+#define ATTEMPT_COMPLETED (1 << 0)
+
+typedef struct {
+    Duration time;    // final time, or the last split's time if reset
+    Duration paused;  // total time spent paused
+    int32_t reached;  // number of splits that were reached
+    uint32_t flags;   // ATTEMPT_*
+} Attempt;
+
+// Every finished or reset attempt, stored column-wise: each segment's
+// times are one contiguous array indexed by attempt, so per-segment
+// statistics are tight loops over a single array.
+typedef struct {
+    int segment_count;
+    int attempt_count;
+    int attempt_cap;
+    // segments[segment][attempt] is how long the segment took, or
+    // DURATION_NONE if it wasn't reached or was skipped (in which
+    // case the next reached segment's time covers it too).
+    Duration** segments;
+    Attempt* attempts;
+    // sketches[segment] summarizes the segment's times, kept up to date
+    // as attempts are added.
+    Sketch* sketches;
+    // Set while snapshots may still be reading the columns and attempts,
+    // which are then moved instead of reallocated, and freed once the
+    // last snapshot is released.
+    struct HistoryPin* pin;
+} History;
+
+void history_init(History* h, int segment_count);
+void history_free(History* h);
+// Make room for at least `attempt_cap` attempts.
+void history_reserve(History* h, int attempt_cap);
+// Record an attempt from its split times (cumulative, with DURATION_NONE
+// for skipped splits), of which the first `reached` were reached.
+// Returns the attempt's index.
+int  history_add(History* h, const Duration* split_times, int reached, Duration paused);
+// Append an attempt as-is, with its segment times (one per segment).
+int  history_append(History* h, Attempt attempt, const Duration* segment_times);
+// Rebuild the sketches from the segments' times, after they've been
+// filled in directly.
+void history_build_sketches(History* h);
+// Take a read-only snapshot of `h` as it is now, which can be read on
+// another thread while `h` keeps growing (or is freed). The attempts
+// and columns are shared, since only new attempts are ever written.
+// Free with `history_release_snapshot`, from any thread.
+void history_snapshot(History* h, History* snapshot);
+void history_release_snapshot(History* snapshot);
+static inline Duration history_segment(History* h, int segment, int attempt) {
+    return h->segments[segment][attempt];
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "duration.h"
+
+typedef struct {
+    int key;
+    Duration time;
+} InputEvent;
+
+#define INPUT_QUEUE_SIZE 64
+
+// Chain onto the window's key callback so that key presses are
+// timestamped with `clock_now` as soon as they're delivered.
+// Must be called after InitWindow().
+void input_init(void);
+// Queue a timestamped key press. This is what the key callback
+// uses, but it can also be used to inject synthetic events.
+// Returns false if the queue is full.
+bool input_push(InputEvent ev);
+// Pop the oldest queued key press. Returns false if the queue is empty.
+bool input_pop(InputEvent* ev);
+// Wait for up to `seconds` while dispatching window events as they
+// arrive, so that presses aren't stamped when the frame ends.
+void input_wait(double seconds);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fiesta/str.h>
+
+#include "duration.h"
+
+typedef enum {
+    JournalStart,
+    JournalSplit,
+    JournalPause,
+    JournalResume,
+    JournalStop,
+    JournalReset,
+    JournalUndo
+} JournalEventType;
+
+typedef struct {
+    uint32_t type;       // JournalEventType
+    int32_t split_index; // split that the event applied to
+    Duration time;       // `clock_now` time of the event
+} JournalRecord;
+
+#define JOURNAL_MAGIC   "SPLTJRNL"
+#define JOURNAL_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t clock;  // ClockSource that the times were read from
+    uint64_t count;  // number of records that have been written
+    uint64_t reserved;
+} JournalHeader;
+
+// An append-only log of timer events, backed by a memory-mapped
+// file. Appending is a store into the mapping and never a system call,
+// so it's safe to do from the render loop: the mapping reserves room
+// for JOURNAL_MAX_CAP records up front, and `thread` extends the file
+// under it well before the records reach its end. Records reach the
+// disk through normal writeback, so they survive the process crashing
+// but not the machine.
+//
+// Only the run in progress is needed to recover it, so a reset starts
+// the journal over, and opening one without a run in progress shrinks
+// it back to JOURNAL_INITIAL_CAP.
+typedef struct {
+    int fd;
+    JournalHeader* header;
+    JournalRecord* records;
+    size_t cap; // number of records that fit in the file so far
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool grow;  // `thread` has been asked to extend the file
+    bool stop;
+} Journal;
+
+#define JOURNAL_INITIAL_CAP 65'536
+#define JOURNAL_MAX_CAP     (1 << 24)
+
+// Open (or create) a journal file. Returns false if the file couldn't
+// be opened or mapped, or isn't a journal.
+bool journal_open(Journal* j, str filename);
+void journal_close(Journal* j);
+// Append an event. After a reset, which ends the run, the journal
+// starts over. Returns false if the file couldn't be extended in time.
+bool journal_append(Journal* j, JournalEventType type, int split_index, Duration time);
+// Number of records in the journal.
+size_t journal_count(Journal* j);
+// Find the index of the start record of the run that was in progress
+// when the journal was last written to (i.e. one that was never reset).
+// Returns `journal_count` if there isn't one.
+size_t journal_find_run(Journal* j);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <fiesta/str.h>
+
+#include "array.h"
+#include "duration.h"
+#include "saver.h"
+
+// What the library knows about one .splits file, without loading it.
+typedef struct {
+    str filename;      // path to the file
+    str game;          // empty if unknown
+    str category;
+    int segment_count;
+    int attempt_count;
+    Duration pb;       // DURATION_NONE without a completed attempt
+    int64_t mtime;     // nanoseconds, to tell whether it has changed
+    int64_t size;
+} Listing;
+
+void listing_free(Listing l);
+_GENERATE_FUNCTION_PROTOTYPES(Listing, listing)
+
+// Every .splits file in a directory, sorted by game, category and
+// filename.
+typedef struct {
+    Listings listings;
+    str dir;
+    Saver index; // writes the index file off the render thread
+} Library;
+
+/* Library index file (native byte order), caching the listings so that
+   only files that changed since have to be read again:
+   - LibraryIndexHeader
+   - LibraryIndexRecord[count]
+   - string table: the records' strings, NUL-terminated */
+
+#define LIBRARY_INDEX_MAGIC   "SPLTLIB"
+#define LIBRARY_INDEX_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t strings_size;
+} LibraryIndexHeader;
+
+typedef struct {
+    uint32_t filename_offset; // into the string table
+    uint32_t filename_len;
+    uint32_t game_offset;
+    uint32_t game_len;
+    uint32_t category_offset;
+    uint32_t category_len;
+    int32_t segment_count;
+    int32_t attempt_count;
+    Duration pb;
+    int64_t mtime;
+    int64_t size;
+} LibraryIndexRecord;
+
+// List the .splits files in `dir`, using the index file to skip the
+// ones that haven't changed since it was written, and update the index
+// if anything did.
+void library_open(Library* lib, str dir, str index_filename);
+// List the directory again, reading only the files that changed since
+// it was last listed.
+void library_refresh(Library* lib);
+void library_free(Library* lib);
+// Index of the listing for `filename`, or -1.
+int  library_find(Library* lib, str filename);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <pthread.h>
+
+#include "history.h"
+#include "splitter.h"
+
+// Loads a mapped binary splits file's history on a background thread,
+// so that the splits can be shown before a long history is decoded.
+typedef struct {
+    pthread_t thread;
+    SplitsMap* map; // must stay mapped until the load is finished
+    History history;
+    bool ok;
+    bool done;      // set by the thread once `history` is complete
+    bool active;
+} HistoryLoader;
+
+void history_loader_start(HistoryLoader* l, SplitsMap* map);
+// Once the history is loaded (or right away, waiting for it, if `wait`),
+// move it into `h`. Attempts recorded in `h` in the meantime are kept,
+// after the loaded ones. Returns the number of attempts that were loaded,
+// or -1 if it isn't done yet, nothing is being loaded, or the history
+// couldn't be loaded, in which case `h` is left as it was.
+int history_loader_poll(HistoryLoader* l, History* h, bool wait);
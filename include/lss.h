@@ -0,0 +1,15 @@
+#pragma once
+
+#include <fiesta/str.h>
+
+#include "history.h"
+#include "splitter.h"
+
+// Import a LiveSplit .lss file in one streaming pass: the game and
+// category, segment names and personal best split times go into `map`
+// (without `data`), and the attempt history and per-segment histories
+// into `history`. Memory use is
+// bounded by the result (plus the largest single XML token, e.g. an
+// embedded icon), not by the file's size. Returns false if the file
+// can't be opened or isn't a LiveSplit run.
+bool lss_import(str filename, SplitsMap* map, History* history);
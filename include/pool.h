@@ -0,0 +1,32 @@
+#pragma once
+
+#include <pthread.h>
+
+// A fixed set of worker threads that run batches of independent tasks.
+typedef void (*PoolTask)(void* arg, int task);
+
+typedef struct {
+    pthread_t* threads;
+    int thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    bool stop;
+    // The batch being run. Tasks are claimed by taking `next`.
+    PoolTask fn;
+    void* arg;
+    int task_count;
+    int next;
+    int finished;
+    unsigned generation; // counts batches, so workers don't run one twice
+} Pool;
+
+// Start `thread_count` workers, or one fewer than the number of CPUs
+// if it's 0 (the thread calling `pool_run` works too). A negative count
+// leaves that many more CPUs free.
+void pool_init(Pool* p, int thread_count);
+void pool_free(Pool* p);
+// Run `fn(arg, task)` for every task in [0, task_count), returning once
+// all are done. Without a pool (NULL), they run on the calling thread.
+// Only one thread at a time may run batches on a pool.
+void pool_run(Pool* p, int task_count, PoolTask fn, void* arg);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+#include <fiesta/str.h>
+
+// Produces a whole file's data (setting `size`) on the saver's thread,
+// e.g. by serializing a snapshot, and frees `arg`.
+typedef void* (*SaverEncode)(void* arg, size_t* size);
+// Frees `arg` instead, if the save is dropped before it starts.
+typedef void (*SaverDrop)(void* arg);
+
+// Writes a file on a background thread, so that saving never makes
+// the render loop wait on the disk. Whole-file saves go to a temporary
+// file which is synced and then renamed over the target, so a crash
+// mid-save leaves either the old file or the new one. Appends are
+// synced too, and written in the order they were submitted.
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stop;
+    char* filename;
+    // The newest whole-file save that hasn't been started yet.
+    // Submitting another before it's started replaces it, since
+    // only the newest matters.
+    void* data;
+    size_t size;
+    // Or what produces it, if it's still to be encoded.
+    SaverEncode encode;
+    SaverDrop drop;
+    void* arg;
+    // Appends submitted since, concatenated.
+    char* append;
+    size_t append_size;
+    size_t append_cap;
+    // The file as it was after the last write, to tell the saver's own
+    // changes apart from anything else's.
+    struct stat written;
+    bool writing;
+    // Size of the last whole file written, 0 if none has been.
+    size_t replaced_size;
+} Saver;
+
+void saver_init(Saver* s, str filename);
+// Queue `data` (which the saver takes ownership of) to replace the
+// whole file. Queued saves and appends that haven't started yet are
+// dropped, since `data` has to include them anyway.
+void saver_replace(Saver* s, void* data, size_t size);
+// Like `saver_replace`, but with the data produced by `encode(arg)` on
+// the saver's thread when the save starts.
+void saver_replace_encoded(Saver* s, SaverEncode encode, SaverDrop drop, void* arg);
+// Size of the last whole file written, 0 if none has been yet.
+size_t saver_replaced_size(Saver* s);
+// Queue `data` (copied) to be appended to the file.
+void saver_append(Saver* s, const void* data, size_t size);
+// Whether `st` is the file as the saver left it, or the saver is
+// writing it right now.
+bool saver_wrote(Saver* s, const struct stat* st);
+// Finish any queued saves and stop the thread.
+void saver_close(Saver* s);
+
+// Write a file by writing a temporary file, syncing it, and
+// renaming it over `filename`.
+bool save_atomic(const char* filename, const void* data, size_t size);
+// Append to a file and sync it.
+bool save_append(const char* filename, const void* data, size_t size);
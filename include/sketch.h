@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "duration.h"
+
+// A merging t-digest: an approximation of a segment's distribution of
+// times in constant memory, no matter how many are added. Times are
+// summarized by centroids (a mean and how many times it stands for),
+// small near the extremes and large in the middle, so the tails stay
+// accurate. New times are buffered and merged in batches.
+#define SKETCH_COMPRESSION 100
+#define SKETCH_CENTROIDS   SKETCH_COMPRESSION // about half are ever used
+#define SKETCH_BUFFER      512
+
+typedef struct {
+    double mean;
+    double weight;
+} SketchCentroid;
+
+typedef struct {
+    int count;    // centroids
+    int buffered; // times not yet merged
+    double total; // weight of the centroids
+    Duration min;
+    Duration max;
+    SketchCentroid centroids[SKETCH_CENTROIDS];
+    Duration buffer[SKETCH_BUFFER];
+} Sketch;
+
+// How a sketch is stored: this, then SketchCentroid[count].
+typedef struct {
+    Duration min;
+    Duration max;
+    uint32_t count;
+    uint32_t reserved;
+} SketchRecord;
+
+void sketch_init(Sketch* s);
+// Copy only the centroids and times in use.
+void sketch_copy(Sketch* dst, const Sketch* src);
+// Add a time (DURATION_NONE is ignored).
+void sketch_add(Sketch* s, Duration time);
+// Merge the buffered times into the centroids.
+void sketch_flush(Sketch* s);
+// Number of times added.
+int64_t sketch_count(Sketch* s);
+// Estimated time at quantile `q` (0 is the best, 1 the worst), or
+// DURATION_NONE if there are no times.
+Duration sketch_quantile(Sketch* s, double q);
+// Estimate `count` evenly spaced quantiles, at (i + 0.5) / count, in one
+// pass. A time drawn from them at random follows the distribution.
+void sketch_quantiles(Sketch* s, int count, Duration* out);
+// Size of the sketch's record once flushed.
+size_t sketch_encoded_size(Sketch* s);
+// Flush and encode the sketch into `out`, returning its size.
+size_t sketch_encode(Sketch* s, void* out);
+// Decode a sketch, returning the size of its record, or 0 if the data
+// is truncated or malformed.
+size_t sketch_decode(Sketch* s, const void* data, size_t size);
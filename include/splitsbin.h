@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fiesta/str.h>
+
+#include "duration.h"
+#include "history.h"
+#include "splitter.h"
+
+/* Binary .splits format (native byte order):
+   - SplitsBinHeader
+   - SplitsBinSegment[segment_count]
+   - string table: NUL-terminated strings. From version 3, the game
+     and category come first, then the segment names.
+   - attempt history: Attempt[attempt_count], then the segments' times:
+     - version 1: for each segment, Duration[attempt_count]
+     - version 2: uint64_t offsets[segment_count + 1] into the data
+       that follows, where segment i's times are encoded as a column
+       (see column.h) in [offsets[i], offsets[i + 1])
+   - from version 4, the segments' sketches (see sketch.h): for each
+     segment a SketchRecord and its centroids, after the history.
+     Without them, the sketches are rebuilt from the history.
+   - update log: records appended by incremental saves, each a
+     SplitsBinUpdate and its payload, applied in order when loading.
+     Saving the whole file again folds them into the body. */
+
+#define SPLITS_BIN_MAGIC   "SPLTBIN"
+#define SPLITS_BIN_VERSION 4
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t segment_count;
+    uint64_t segments_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t history_offset;
+    uint64_t history_size;
+    uint32_t attempt_count;
+    uint32_t reserved;
+    // From version 4; older headers end before these.
+    uint64_t sketches_offset;
+    uint64_t sketches_size;
+} SplitsBinHeader;
+
+typedef enum {
+    SplitsUpdateSplit = 1,   // payload: the split's new Duration time
+    SplitsUpdateAttempt = 2  // payload: Attempt, then Duration[segment_count]
+} SplitsUpdateType;
+
+typedef struct {
+    uint32_t type;     // SplitsUpdateType
+    uint32_t size;     // of the payload, a multiple of 8
+    uint32_t index;    // of the split or attempt
+    uint32_t checksum; // of the payload, to catch torn appends
+} SplitsBinUpdate;
+
+typedef struct {
+    uint32_t name_offset; // into the string table
+    uint32_t name_len;
+    Duration time;
+} SplitsBinSegment;
+
+// Check whether a file starts with the binary splits magic.
+bool splits_is_binary(str filename);
+// Map a binary splits file, with the names (and game and category)
+// pointing into the mapping.
+// Returns false if it can't be opened or isn't a valid binary splits file.
+bool splits_map(SplitsMap* m, str filename);
+// Copy a mapped file's attempt history and sketches into `h` (which is
+// initialized). Split times and attempts from the update log are applied
+// as well.
+// Returns false, leaving `h` empty, if the history is corrupt.
+bool splits_map_history(SplitsMap* m, History* h);
+// What a library listing shows: the number of attempts, and the best
+// completed attempt's time (DURATION_NONE if none were completed). Only
+// the attempt records are read, not the segment columns.
+void splits_map_summary(SplitsMap* m, int* attempt_count, Duration* pb);
+// Serialize splits with their game and category, and their attempt
+// history and sketches if `history` isn't NULL, into a newly allocated
+// buffer.
+void* splits_serialize_binary(const SplitsMap* m, History* history, size_t* size);
+// Size of the update record for a split or an attempt.
+size_t splits_update_split_size(void);
+size_t splits_update_attempt_size(int segment_count);
+// Encode an update record into `out`, returning its size.
+size_t splits_encode_split_update(void* out, int index, Duration time);
+size_t splits_encode_attempt_update(void* out, History* h, int attempt);
+// Serialize and atomically save splits (see `splits_serialize_binary`).
+bool splits_save_binary(str filename, const SplitsMap* m, History* history);
@@ -1,53 +1,188 @@
 #pragma once
 
 #include <stdint.h>
-#include <time.h>
 
 #include <fiesta/str.h>
+#include <raylib.h>
 
 #include "array.h"
+#include "comparison.h"
+#include "duration.h"
+#include "forecast.h"
+#include "history.h"
+#include "input.h"
+#include "journal.h"
+#include "pool.h"
+#include "stats.h"
 
 typedef struct {
     str name;
-    struct timespec time;
+    Duration time;
 } Split;
 
-Split split_create(str name, struct timespec time);
+Split split_create(str name, Duration time);
 void split_free(Split s);
 _GENERATE_FUNCTION_PROTOTYPES(Split, split)
 
-Splits splits_load(str filename);
+// Splits whose names all live in one block of memory (a mapped binary
+// file, or the names parsed out of a text file) instead of being
+// allocated one by one. Free with `splits_unmap`, not `splits_free`.
+// Without `data`, the names are allocated one by one like any Splits.
+typedef struct {
+    void* data;
+    size_t size;
+    bool mapped;
+    Splits splits;
+    // What the splits are for, if known (empty otherwise). They live
+    // in `data` like the names, or are allocated if there's no `data`.
+    str game;
+    str category;
+} SplitsMap;
+
+// Load a text splits file. Returns false if it can't be opened.
+bool splits_load(SplitsMap* m, str filename);
 void splits_save(str filename, Splits splits);
+void splits_unmap(SplitsMap* m);
+// Free the splits whether or not they have `data`.
+void splits_release(SplitsMap* m);
+
+typedef struct {
+    Duration start;
+    Duration end; // DURATION_NONE while still paused
+} Pause;
+
+void pause_free(Pause p);
+_GENERATE_FUNCTION_PROTOTYPES(Pause, pause)
 
 typedef struct {
-    struct timespec start;
-    struct timespec cur;
+    Duration start;
+    Duration cur;
+    // Total length of all finished pauses, so that
+    // elapsed time is `cur - start - paused`.
+    Duration paused;
+    // Every pause/resume interval of the current run, until it's reset.
+    // Only their total is recorded with the attempt in the history.
+    Pauses pauses;
     bool running;
     bool finished;
 } Timer;
 
-void timer_start(Timer* t);
-void timer_stop(Timer* t);
-void timer_toggle_pause(Timer* t);
+void timer_start(Timer* t, Duration time);
+void timer_stop(Timer* t, Duration time);
+void timer_toggle_pause(Timer* t, Duration time);
 void timer_reset(Timer* t);
+void timer_free(Timer* t);
 void timer_update(Timer* t);
+// Time spent running (i.e. not paused) between the start and `time`.
+Duration timer_elapsed_at(Timer* t, Duration time);
+Duration timer_elapsed(Timer* t);
+bool timer_paused(Timer* t);
+// Whether the timer has been started since it was last reset.
+bool timer_started(Timer* t);
 
 typedef struct {
     double split_height;
     double timer_size;
 } Layout;
 
+#define LAYOUT_DEFAULT ((Layout){.split_height = 40, .timer_size = 50})
+
+// Load a layout from lines of `<field> <value>`, e.g. `split_height 40`.
+// Fields that aren't given are LAYOUT_DEFAULT's. `layout` is left as it
+// was if the file can't be read or has unknown fields.
+bool layout_load(Layout* layout, str filename);
+
+// Text that `splitter_draw` formats and measures once, and again only
+// when the value it shows or its font size changes.
+typedef struct {
+    bool valid;
+    Duration value; // that `text` shows
+    int size;       // font size that `width` was measured at
+    int width;
+    char text[64];
+} CachedText;
+
+typedef enum {
+    DeltaHidden,
+    DeltaGold,   // a best segment
+    DeltaAhead,
+    DeltaBehind
+} SplitDelta;
+
+typedef struct {
+    const char* name_data; // the name that `name` is a copy of
+    int name_len;
+    char name[128];
+    CachedText time;
+    CachedText delta;
+    SplitDelta delta_kind;
+} SplitText;
+
+typedef struct {
+    // The rows and the run info as last drawn, redrawn when they change.
+    RenderTexture2D rows;
+    SplitText* splits;
+    int split_count;
+    CachedText sum_of_best;
+    CachedText best_possible;
+    CachedText comparing;
+    CachedText chance;
+    // When the rows don't all fit, a window of them is shown above the
+    // final split. `top` is its first row, fractional while it scrolls
+    // to `target`.
+    double top;
+    double target;
+    double drawn_top;  // `top` that `rows` was drawn at
+    int followed;      // cur_split_index that `target` was last moved for
+    bool scrolled;     // by hand, so `target` stays put until the next split
+} DrawCache;
+
+void draw_cache_free(DrawCache* c);
+
 typedef struct {
     Layout layout;
     Splits splits;
     int cur_split_index;
     Timer timer;
+    History history;
+    Comparisons comparisons;
+    SegmentStats stats;
+    int compare_stat; // SegmentStat that deltas are against, or -1 for the PB
+    Pool* pool;       // optional, to compute the statistics on
+    Forecast* forecast; // optional, estimates the chance of a PB
+    Journal* journal; // optional, records every timer event
+    struct Autosave* autosave; // optional, tracks splits that need saving
+    DrawCache* draw_cache;     // optional, keeps text between frames
 } SplitterState;
 
-void splitter_start(SplitterState* ss);
-void splitter_stop(SplitterState* ss);
-void splitter_toggle_pause(SplitterState* ss);
+// `time` is when the triggering input arrived, so that
+// recorded times don't depend on when the frame ran.
+void splitter_start(SplitterState* ss, Duration time);
+void splitter_stop(SplitterState* ss, Duration time);
+void splitter_toggle_pause(SplitterState* ss, Duration time);
+// Reset the run, adding it to the history if it was started, and show
+// the personal best's split times until the next run reaches them.
 void splitter_reset(SplitterState* ss);
 void splitter_update(SplitterState* ss);
-void splitter_split(SplitterState* ss);
+void splitter_split(SplitterState* ss, Duration time);
+// Take back the last split, resuming the timer if it had finished.
+void splitter_undo_split(SplitterState* ss);
+// Compute the comparisons again after the splits or history changed,
+// keeping the run in progress.
+void splitter_load_comparisons(SplitterState* ss);
+// Compare the run to a SegmentStat, or to the PB if `stat` is -1.
+void splitter_compare_to(SplitterState* ss, int stat);
+// Rebuild the run from journal records. The records aren't journaled again.
+void splitter_replay(SplitterState* ss, const JournalRecord* records, size_t count);
+// Restore the run that was in progress when the journal was last written
+// to (e.g. before a crash), switching to the clock that it was timed with.
+// Returns false if there's nothing that can be restored. A run that
+// can't be is closed with a reset, so it's never restored later.
+bool splitter_recover(SplitterState* ss);
+// Act on a timer key (space, P, R or U), stamped with the press's time.
+// Returns false for any other key.
+bool splitter_press(SplitterState* ss, InputEvent ev);
+// Scroll the split rows by hand, by `rows` down (or up if negative).
+// They follow the run again on its next split or undo.
+void splitter_scroll(SplitterState* ss, double rows);
 void splitter_draw(SplitterState ss);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "duration.h"
+#include "history.h"
+#include "pool.h"
+
+typedef enum {
+    StatAverage,
+    StatMedian,
+    StatWorst,
+    StatLatest,
+    StatP10,
+    StatP90,
+    StatCount
+} SegmentStat;
+
+// A segment's time at one rank of its sorted times, along with how many
+// times are below it and equal to it. Adding a time moves the rank by
+// at most one place, so the next value is found with one pass over the
+// column instead of selecting again.
+typedef struct {
+    Duration value;
+    int below;
+    int equal;
+} Quantile;
+
+#define QUANTILE_COUNT 3 // median, 10th and 90th percentile
+
+// From this many attempts on, the quantiles are estimated from the
+// history's sketches instead of being tracked exactly, which takes a
+// pass over the column whenever one moves.
+#define STATS_SKETCH_ATTEMPTS 10'000
+
+// Statistics of each segment's times over the whole history.
+typedef struct {
+    int segment_count;
+    int attempt_count; // attempts that are included
+    bool sketched;     // whether the quantiles come from the sketches
+    // values[stat][segment], DURATION_NONE for a segment without times.
+    Duration* values[StatCount];
+    int64_t* sums;
+    int* counts;
+    Quantile* quantiles[QUANTILE_COUNT];
+} SegmentStats;
+
+const char* segment_stat_name(SegmentStat stat);
+void segment_stats_free(SegmentStats* s);
+// Compute the statistics of every segment from scratch, one segment
+// per task on `pool` (which may be NULL).
+void segment_stats_compute(SegmentStats* s, History* h, Pool* pool);
+// Include the attempts added to `h` since the statistics were computed.
+void segment_stats_update(SegmentStats* s, History* h, Pool* pool);
+// Cumulative split times from the segments' `stat`, DURATION_NONE from
+// the first segment without one.
+void segment_stats_splits(SegmentStats* s, SegmentStat stat, Duration* splits);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <pthread.h>
+
+#include <fiesta/str.h>
+
+#include "history.h"
+#include "saver.h"
+#include "splitter.h"
+
+// Watches the splits and layout files on a background thread, and
+// loads them again when something else changes them. The loaded files
+// are held until the render loop takes them at a frame boundary.
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int fd; // inotify
+    bool stop;
+    char* splits_filename;
+    char* layout_filename;
+    Saver* saver; // its own saves of the splits are ignored
+    // Loaded and not taken yet. Newer loads replace them.
+    bool splits_ready;
+    SplitsMap map;
+    History history;
+    bool layout_ready;
+    Layout layout;
+} Watcher;
+
+// Start watching. The files are in the working directory. Returns
+// false if watching isn't supported or failed to start.
+bool watcher_start(Watcher* w, str splits_filename, str layout_filename, Saver* saver);
+void watcher_stop(Watcher* w);
+// Segment count of the loaded splits that are waiting, or -1 if none.
+int  watcher_splits_ready(Watcher* w);
+// Take the loaded splits and their history, if there are any.
+bool watcher_take_splits(Watcher* w, SplitsMap* map, History* history);
+bool watcher_take_layout(Watcher* w, Layout* layout);
@@ -5,25 +5,29 @@
 void maybe_realloc(dynobj* obj, int num_new_elements, int element_size) {
     // Allocate more memory if needed.
     if (obj->len + num_new_elements >= obj->cap) {
-        obj->cap += num_new_elements;
-        obj->cap *= DYN_GROWTH_RATE;
-        void* new_ptr = realloc(obj->data, obj->cap * element_size);
-        if (new_ptr) obj->data = new_ptr;
-        memset(new_ptr + obj->len + num_new_elements, 0, num_new_elements * element_size);
+        int cap = (obj->cap + num_new_elements) * DYN_GROWTH_RATE;
+        void* new_ptr = realloc(obj->data, (size_t)cap * element_size);
+        if (!new_ptr)
+            return;
+        // Zero the newly allocated tail (offsets are in bytes, not elements).
+        memset((char*)new_ptr + (size_t)obj->len * element_size, 0, (size_t)(cap - obj->len) * element_size);
+        obj->data = new_ptr;
+        obj->cap = cap;
     }
-    // Reduce memory if over-allocated.
-    else if (num_new_elements < 0 && num_new_elements != -obj->len) {
-        obj->cap -= num_new_elements;
-        void* new_ptr = realloc(obj->data, obj->cap * element_size);
-        if (new_ptr) obj->data = new_ptr;
-        memset(new_ptr + obj->len + num_new_elements, 0, num_new_elements * element_size);
+    /* Reduce memory once the elements (already removed from `len`) take
+    up well under the capacity. Don't go below DYN_BASE_SIZE, so clearing
+    every element doesn't free the allocation (as realloc() with 0 would). */
+    else if (num_new_elements < 0) {
+        int cap = obj->len * DYN_GROWTH_RATE;
+        if (cap < DYN_BASE_SIZE)
+            cap = DYN_BASE_SIZE;
+        if (cap * DYN_GROWTH_RATE >= obj->cap)
+            return;
+        void* new_ptr = realloc(obj->data, (size_t)cap * element_size);
+        if (!new_ptr)
+            return;
+        obj->data = new_ptr;
+        obj->cap = cap;
+        memset((char*)new_ptr + (size_t)obj->len * element_size, 0, (size_t)(cap - obj->len) * element_size);
     }
-    /* But don't free the dynobj if clearing all of its elements
-    (passing 0 to realloc would free the allocation). */
-    else if (num_new_elements == -obj->len) {
-        obj->cap = DYN_BASE_SIZE;
-        void* new_ptr = realloc(obj->data, obj->cap * element_size);
-        if (new_ptr) obj->data = new_ptr;
-        memset(new_ptr, 0, obj->cap * element_size);
-    }
-}
\ No newline at end of file
+}
@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "autosave.h"
+#include "splitsbin.h"
+
+void autosave_init(Autosave* a, int split_count, int attempt_count, size_t body_size, bool saved) {
+    *a = (Autosave){
+        .dirty = calloc((split_count + 63) / 64 + 1, sizeof(uint64_t)),
+        .split_count = split_count,
+        .saved_attempts = attempt_count,
+        .full = !saved,
+        .body_size = body_size
+    };
+}
+
+void autosave_free(Autosave* a) {
+    free(a->dirty);
+    *a = (Autosave){0};
+}
+
+void autosave_mark_split(Autosave* a, int index) {
+    if (index >= 0 && index < a->split_count)
+        a->dirty[index / 64] |= 1ull << (index % 64);
+}
+
+void autosave_mark_all(Autosave* a) {
+    a->full = true;
+}
+
+bool autosave_pending(Autosave* a, History* history) {
+    if (a->full || history->attempt_count != a->saved_attempts)
+        return true;
+    for (int i = 0; i < (a->split_count + 63) / 64; ++i)
+        if (a->dirty[i])
+            return true;
+    return false;
+}
+
+bool autosave_split_dirty(Autosave* a, int index) {
+    return index >= 0 && index < a->split_count && (a->dirty[index / 64] >> (index % 64) & 1);
+}
+
+int autosave_carry_attempts(Autosave* a, History* from, History* to) {
+    if (from->segment_count != to->segment_count)
+        return -1;
+    int count = from->attempt_count - a->saved_attempts;
+    if (count <= 0)
+        return 0;
+    history_reserve(to, to->attempt_count + count);
+    Duration* times = malloc(sizeof(Duration) * (from->segment_count + 1));
+    for (int n = a->saved_attempts; n < from->attempt_count; ++n) {
+        for (int i = 0; i < from->segment_count; ++i)
+            times[i] = history_segment(from, i, n);
+        history_append(to, from->attempts[n], times);
+    }
+    free(times);
+    return count;
+}
+
+// What a whole-file save is serialized from on the saver's thread: a
+// copy of the splits, with their names in one block, and a snapshot of
+// the history.
+typedef struct {
+    SplitsMap map;
+    History history;
+} WholeSave;
+
+static void drop_whole(void* arg) {
+    WholeSave* w = arg;
+    splits_release(&w->map);
+    history_release_snapshot(&w->history);
+    free(w);
+}
+
+static void* encode_whole(void* arg, size_t* size) {
+    WholeSave* w = arg;
+    void* data = splits_serialize_binary(&w->map, &w->history, size);
+    drop_whole(w);
+    return data;
+}
+
+// Copy `s` into `block` at `*offset`, moving it along.
+static str copy_str(char* block, size_t* offset, str s) {
+    str copy = {.data = block + *offset, .len = s.len};
+    if (s.len > 0)
+        memcpy(copy.data, s.data, s.len);
+    copy.data[s.len] = '\0';
+    *offset += s.len + 1;
+    return copy;
+}
+
+// Serializing takes tens of milliseconds for a big history, so it's
+// done by the saver from a snapshot. Taking one only copies the names
+// and the sketches.
+static void save_whole(Autosave* a, Saver* saver, const SplitsMap* m, History* history) {
+    Splits splits = m->splits;
+    size_t size = m->game.len + 1 + m->category.len + 1;
+    for (int i = 0; i < splits.len; ++i)
+        size += splits.data[i].name.len + 1;
+
+    WholeSave* w = malloc(sizeof(WholeSave));
+    char* names = malloc(size);
+    size_t offset = 0;
+    w->map = (SplitsMap){
+        .data = names,
+        .size = size,
+        .splits = {.data = malloc(sizeof(Split) * (splits.len > 0 ? splits.len : 1)), .len = splits.len, .cap = splits.len},
+        .game = copy_str(names, &offset, m->game),
+        .category = copy_str(names, &offset, m->category)
+    };
+    for (int i = 0; i < splits.len; ++i)
+        w->map.splits.data[i] = split_create(copy_str(names, &offset, splits.data[i].name), splits.data[i].time);
+    history_snapshot(history, &w->history);
+    saver_replace_encoded(saver, encode_whole, drop_whole, w);
+
+    a->full = false;
+    a->log_size = 0;
+}
+
+void autosave_flush(Autosave* a, Saver* saver, const SplitsMap* m, History* history) {
+    Splits splits = m->splits;
+    int words = (a->split_count + 63) / 64;
+    size_t size = 0;
+    int new_attempts = history->attempt_count - a->saved_attempts;
+    for (int i = 0; i < words; ++i)
+        size += __builtin_popcountll(a->dirty[i]) * splits_update_split_size();
+    size += new_attempts * splits_update_attempt_size(history->segment_count);
+    // The file's size is only known once the saver has written it.
+    size_t replaced = saver_replaced_size(saver);
+    if (replaced > 0)
+        a->body_size = replaced;
+
+    if (a->full || (int)splits.len != a->split_count || history->segment_count != a->split_count
+        || new_attempts < 0 || a->log_size + size > a->body_size) {
+        save_whole(a, saver, m, history);
+    } else if (size > 0) {
+        char* data = malloc(size);
+        char* p = data;
+        for (int i = 0; i < words; ++i) {
+            for (uint64_t bits = a->dirty[i]; bits; bits &= bits - 1) {
+                int index = i * 64 + __builtin_ctzll(bits);
+                p += splits_encode_split_update(p, index, splits.data[index].time);
+            }
+        }
+        for (int i = a->saved_attempts; i < history->attempt_count; ++i)
+            p += splits_encode_attempt_update(p, history, i);
+        saver_append(saver, data, size);
+        free(data);
+        a->log_size += size;
+    }
+    memset(a->dirty, 0, words * sizeof(uint64_t));
+    a->saved_attempts = history->attempt_count;
+}
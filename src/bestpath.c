@@ -0,0 +1,127 @@
+#include <stdlib.h>
+
+#include "bestpath.h"
+
+void span_free(Span s) {
+    (void)s;
+}
+
+_GENERATE_ARRAY_IMPLEMENTATIONS(Span, span)
+
+static Duration shortest_from(BestPaths* p, int split) {
+    Duration best = DURATION_NONE;
+    Spans spans = p->spans[split];
+    for (int i = 0; i < spans.len; ++i) {
+        Duration rest = p->remaining[spans.data[i].to];
+        if (spans.data[i].time != DURATION_NONE && rest != DURATION_NONE
+            && spans.data[i].time + rest < best)
+            best = spans.data[i].time + rest;
+    }
+    return best;
+}
+
+// Find the shortest paths again after the spans from `split` changed.
+// A split before it only needs looking at if one of its spans leads to
+// a split whose path changed, which `first_into` bounds.
+static void update_before(BestPaths* p, int split) {
+    int limit = split;
+    for (int k = split; k >= limit; --k) {
+        Duration best = shortest_from(p, k);
+        if (best != p->remaining[k]) {
+            p->remaining[k] = best;
+            if (p->first_into[k] < limit)
+                limit = p->first_into[k];
+        }
+    }
+}
+
+// Set a span's time, returning its previous one.
+static Duration put(BestPaths* p, int from, int to, Duration time, bool only_better) {
+    Spans* spans = &p->spans[from];
+    for (int i = 0; i < spans->len; ++i) {
+        Span* s = &spans->data[i];
+        if (s->to == to) {
+            Duration old = s->time;
+            if (!only_better || time < old)
+                s->time = time;
+            return old;
+        }
+    }
+    if (time != DURATION_NONE) {
+        spans_append(spans, (Span){.to = to, .time = time});
+        if (from < p->first_into[to])
+            p->first_into[to] = from;
+    }
+    return DURATION_NONE;
+}
+
+void best_paths_init(BestPaths* p, History* h) {
+    int n = h->segment_count;
+    *p = (BestPaths){
+        .segment_count = n,
+        .spans = malloc(sizeof(Spans) * (n + 1)),
+        .remaining = malloc(sizeof(Duration) * (n + 1)),
+        .first_into = malloc(sizeof(int) * (n + 1))
+    };
+    for (int k = 0; k <= n; ++k) {
+        p->spans[k] = spans_create();
+        p->remaining[k] = DURATION_NONE;
+        p->first_into[k] = k;
+    }
+    // Spans first, then one pass over the splits, rather than updating
+    // the paths for every attempt.
+    for (int i = 0; i < n; ++i) {
+        const Duration* column = h->segments[i];
+        const Duration* prev = i > 0 ? h->segments[i - 1] : NULL;
+        Duration best = DURATION_NONE;
+        for (int a = 0; a < h->attempt_count; ++a) {
+            if (!prev || prev[a] != DURATION_NONE) {
+                best = column[a] < best ? column[a] : best;
+            } else if (column[a] != DURATION_NONE) {
+                // A time after skipped splits spans back to the last one
+                // that wasn't.
+                int from = i - 1;
+                while (from > 0 && h->segments[from - 1][a] == DURATION_NONE)
+                    --from;
+                put(p, from, i + 1, column[a], true);
+            }
+        }
+        put(p, i, i + 1, best, true);
+    }
+    p->remaining[n] = 0;
+    for (int k = n - 1; k >= 0; --k)
+        p->remaining[k] = shortest_from(p, k);
+}
+
+void best_paths_free(BestPaths* p) {
+    // Comparisons start out zeroed, and are freed before they're computed.
+    if (!p->spans)
+        return;
+    for (int k = 0; k <= p->segment_count; ++k)
+        spans_free(p->spans[k]);
+    free(p->spans);
+    free(p->remaining);
+    free(p->first_into);
+    *p = (BestPaths){0};
+}
+
+Duration best_paths_span(const BestPaths* p, int from, int to) {
+    Spans spans = p->spans[from];
+    for (int i = 0; i < spans.len; ++i)
+        if (spans.data[i].to == to)
+            return spans.data[i].time;
+    return DURATION_NONE;
+}
+
+bool best_paths_offer(BestPaths* p, int from, int to, Duration time) {
+    if (time == DURATION_NONE || time >= put(p, from, to, time, true))
+        return false;
+    update_before(p, from);
+    return true;
+}
+
+void best_paths_set(BestPaths* p, int from, int to, Duration time) {
+    Duration old = put(p, from, to, time, false);
+    if (time != old)
+        update_before(p, from);
+}
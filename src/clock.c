@@ -0,0 +1,204 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include <raylib.h>
+
+#include "clock.h"
+
+#define MEASURE_READS 100'000
+// How long to spin for when first calibrating the TSC.
+#define TSC_CALIBRATION_TIME (20 * NSEC_PER_MSEC)
+// How often (in TSC ticks) to refine the TSC's rate.
+#define TSC_REFINE_TICKS (1ULL << 30)
+
+static ClockSource selected = ClockMonotonic;
+static Duration virtual_now = 0;
+
+static Duration read_posix(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return duration_from_timespec(ts);
+}
+
+static Duration read_monotonic(void) {
+    return read_posix(CLOCK_MONOTONIC);
+}
+
+#ifdef CLOCK_MONOTONIC_RAW
+static Duration read_monotonic_raw(void) {
+    return read_posix(CLOCK_MONOTONIC_RAW);
+}
+#endif
+
+#ifdef CLOCK_BOOTTIME
+static Duration read_boottime(void) {
+    return read_posix(CLOCK_BOOTTIME);
+}
+#endif
+
+static Duration read_virtual(void) {
+    return virtual_now;
+}
+
+#ifdef HAVE_TSC
+// TSC ticks are converted as `base_ns + (ticks - base_ticks) * mult >> 32`.
+// `mult` is periodically refined against CLOCK_MONOTONIC over the whole
+// time since calibration, and `base_*` re-anchored so the output stays
+// continuous.
+static struct {
+    bool calibrated;
+    uint64_t origin_ticks;
+    Duration origin_ns;
+    uint64_t base_ticks;
+    Duration base_ns;
+    uint64_t mult;
+} tsc = {0};
+
+static bool tsc_invariant(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x8000'0007, &eax, &ebx, &ecx, &edx))
+        return false;
+    return edx & (1 << 8);
+}
+
+static Duration tsc_convert(uint64_t ticks) {
+    return tsc.base_ns + (Duration)(((unsigned __int128)(ticks - tsc.base_ticks) * tsc.mult) >> 32);
+}
+
+static void tsc_calibrate(void) {
+    tsc.origin_ns = read_monotonic();
+    tsc.origin_ticks = __rdtsc();
+    Duration ns;
+    uint64_t ticks;
+    do {
+        ns = read_monotonic();
+        ticks = __rdtsc();
+    } while (ns - tsc.origin_ns < TSC_CALIBRATION_TIME);
+    tsc.mult = ((unsigned __int128)(ns - tsc.origin_ns) << 32) / (ticks - tsc.origin_ticks);
+    tsc.base_ticks = tsc.origin_ticks;
+    tsc.base_ns = tsc.origin_ns;
+    tsc.calibrated = true;
+}
+
+static Duration read_tsc(void) {
+    uint64_t ticks = __rdtsc();
+    if (ticks - tsc.base_ticks >= TSC_REFINE_TICKS) {
+        tsc.base_ns = tsc_convert(ticks);
+        tsc.base_ticks = ticks;
+        tsc.mult = ((unsigned __int128)(read_monotonic() - tsc.origin_ns) << 32) / (ticks - tsc.origin_ticks);
+    }
+    return tsc_convert(ticks);
+}
+#endif
+
+static Duration (*readers[ClockSourceCount])(void) = {
+    [ClockMonotonic] = read_monotonic,
+#ifdef CLOCK_MONOTONIC_RAW
+    [ClockMonotonicRaw] = read_monotonic_raw,
+#endif
+#ifdef CLOCK_BOOTTIME
+    [ClockBoottime] = read_boottime,
+#endif
+#ifdef HAVE_TSC
+    [ClockTsc] = read_tsc,
+#endif
+    [ClockVirtual] = read_virtual,
+};
+
+static const char* names[ClockSourceCount] = {
+    [ClockMonotonic] = "CLOCK_MONOTONIC",
+    [ClockMonotonicRaw] = "CLOCK_MONOTONIC_RAW",
+    [ClockBoottime] = "CLOCK_BOOTTIME",
+    [ClockTsc] = "TSC",
+    [ClockVirtual] = "virtual",
+};
+
+Duration clock_now(void) {
+    return readers[selected]();
+}
+
+bool clock_select(ClockSource source) {
+    if (!clock_available(source))
+        return false;
+#ifdef HAVE_TSC
+    if (source == ClockTsc && !tsc.calibrated)
+        tsc_calibrate();
+#endif
+    selected = source;
+    return true;
+}
+
+ClockSource clock_selected(void) {
+    return selected;
+}
+
+bool clock_available(ClockSource source) {
+    if (source < 0 || source >= ClockSourceCount || !readers[source])
+        return false;
+#ifdef HAVE_TSC
+    if (source == ClockTsc)
+        return tsc_invariant();
+#endif
+    return true;
+}
+
+const char* clock_name(ClockSource source) {
+    return names[source];
+}
+
+ClockStats clock_measure(ClockSource source) {
+    ClockStats stats = {.granularity = DURATION_NONE};
+    Duration (*read)(void) = readers[source];
+#ifdef HAVE_TSC
+    if (source == ClockTsc && !tsc.calibrated)
+        tsc_calibrate();
+#endif
+
+    Duration start = read_monotonic();
+    for (int i = 0; i < MEASURE_READS; ++i)
+        read();
+    stats.read_cost = (read_monotonic() - start) / MEASURE_READS;
+
+    Duration prev = read();
+    for (int i = 0; i < MEASURE_READS; ++i) {
+        Duration cur = read();
+        if (cur != prev && cur - prev < stats.granularity)
+            stats.granularity = cur - prev;
+        prev = cur;
+    }
+    return stats;
+}
+
+ClockSource clock_select_best(void) {
+    ClockSource best = ClockMonotonic;
+    Duration best_cost = DURATION_NONE;
+    for (ClockSource source = 0; source < ClockSourceCount; ++source) {
+        if (source == ClockVirtual || !clock_available(source))
+            continue;
+        ClockStats stats = clock_measure(source);
+        TraceLog(LOG_INFO, "CLOCK: %-19s read cost: %3"PRIi64" ns, granularity: %"PRIi64" ns",
+                 clock_name(source), stats.read_cost, stats.granularity);
+        if (stats.granularity <= NSEC_PER_USEC && stats.read_cost < best_cost) {
+            best = source;
+            best_cost = stats.read_cost;
+        }
+    }
+    clock_select(best);
+    TraceLog(LOG_INFO, "CLOCK: Using %s", clock_name(best));
+    return best;
+}
+
+void clock_virtual_set(Duration time) {
+    virtual_now = time;
+}
+
+void clock_virtual_advance(Duration d) {
+    virtual_now += d;
+}
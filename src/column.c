@@ -0,0 +1,163 @@
+#include <string.h>
+
+#include "column.h"
+
+// Deltas are taken in unsigned arithmetic, where overflow wraps instead
+// of being undefined, so that any values round-trip exactly.
+
+static uint64_t zigzag(uint64_t v) {
+    return (v << 1) ^ (uint64_t)((int64_t)v >> 63);
+}
+
+static uint64_t unzigzag(uint64_t v) {
+    return (v >> 1) ^ -(v & 1);
+}
+
+static uint8_t* put_varint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static const uint8_t* get_varint(const uint8_t* p, const uint8_t* end, uint64_t* v) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            *v = result;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static const int64_t pow10[] = {
+    1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000, 1'000'000'000
+};
+
+size_t column_encoded_bound(size_t count) {
+    size_t blocks = (count + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+    // Header byte, size varint and NONE bitmap per block,
+    // and a varint of at most 10 bytes per value.
+    return blocks * (1 + 3 + COLUMN_BLOCK / 8) + count * 10;
+}
+
+size_t column_encode(const Duration* values, size_t count, uint8_t* out) {
+    uint8_t* p = out;
+    uint8_t body[COLUMN_BLOCK / 8 + COLUMN_BLOCK * 10];
+    for (size_t start = 0; start < count; start += COLUMN_BLOCK) {
+        size_t n = count - start < COLUMN_BLOCK ? count - start : COLUMN_BLOCK;
+        const Duration* v = values + start;
+
+        int exp = 9;
+        bool has_none = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (v[i] == DURATION_NONE)
+                has_none = true;
+            else
+                while (exp > 0 && v[i] % pow10[exp] != 0)
+                    --exp;
+        }
+
+        uint8_t* q = body;
+        if (has_none) {
+            memset(q, 0, (n + 7) / 8);
+            for (size_t i = 0; i < n; ++i)
+                if (v[i] == DURATION_NONE)
+                    q[i / 8] |= 1 << (i % 8);
+            q += (n + 7) / 8;
+        }
+        uint64_t prev = 0;
+        uint64_t prev_delta = 0;
+        size_t present = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (v[i] == DURATION_NONE)
+                continue;
+            uint64_t x = (uint64_t)(v[i] / pow10[exp]);
+            uint64_t delta = x - prev;
+            q = put_varint(q, zigzag(present < 2 ? delta : delta - prev_delta));
+            prev = x;
+            prev_delta = delta;
+            ++present;
+        }
+
+        *p++ = exp | (has_none ? COLUMN_HAS_NONE : 0);
+        p = put_varint(p, q - body);
+        memcpy(p, body, q - body);
+        p += q - body;
+    }
+    return p - out;
+}
+
+// Decode `n` zig-zag varints of delta-of-deltas into values. Kept
+// separate from the NONE handling so that the common case, a block
+// without any, is one tight loop that writes straight to the output.
+static const uint8_t* decode_values(const uint8_t* p, const uint8_t* end, int64_t scale,
+                                    Duration* out, size_t n) {
+    uint64_t prev = 0;
+    uint64_t delta = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t v;
+        uint64_t word;
+        uint64_t last;
+        // Fast path: with 8 bytes to read, find the varint's last byte
+        // from the continuation bits and gather its 7-bit groups without
+        // looping byte by byte. Varints of up to 8 bytes (56 bits) fit.
+        if (end - p >= 8 && (memcpy(&word, p, 8), last = ~word & 0x8080808080808080)) {
+            int bits = __builtin_ctzll(last) + 1;
+            word &= bits == 64 ? ~0ull : (1ull << bits) - 1;
+            v = (word & 0x7f) | (word >> 1 & 0x3f80) | (word >> 2 & 0x1fc000)
+                | (word >> 3 & 0xfe00000) | (word >> 4 & 0x7f0000000)
+                | (word >> 5 & 0x3f800000000) | (word >> 6 & 0x1fc0000000000)
+                | (word >> 7 & 0xfe000000000000);
+            p += bits / 8;
+        } else if (!(p = get_varint(p, end, &v))) {
+            return NULL;
+        }
+        v = unzigzag(v);
+        delta = i < 2 ? v : delta + v;
+        prev += delta;
+        out[i] = (int64_t)prev * scale;
+    }
+    return p;
+}
+
+bool column_decode(const uint8_t* data, size_t size, Duration* values, size_t count) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    Duration present[COLUMN_BLOCK];
+    for (size_t start = 0; start < count; start += COLUMN_BLOCK) {
+        size_t n = count - start < COLUMN_BLOCK ? count - start : COLUMN_BLOCK;
+        Duration* v = values + start;
+        uint64_t body_size;
+        if (p == end)
+            return false;
+        uint8_t header = *p++;
+        if ((header & ~COLUMN_HAS_NONE) > 9 || !(p = get_varint(p, end, &body_size))
+            || body_size > (uint64_t)(end - p))
+            return false;
+        int64_t scale = pow10[header & ~COLUMN_HAS_NONE];
+        const uint8_t* body_end = p + body_size;
+
+        if (!(header & COLUMN_HAS_NONE)) {
+            p = decode_values(p, body_end, scale, v, n);
+        } else {
+            if ((size_t)(body_end - p) < (n + 7) / 8)
+                return false;
+            const uint8_t* none = p;
+            size_t none_count = 0;
+            for (size_t i = 0; i < n; ++i)
+                none_count += none[i / 8] >> (i % 8) & 1;
+            p = decode_values(p + (n + 7) / 8, body_end, scale, present, n - none_count);
+            for (size_t i = 0, j = 0; i < n; ++i)
+                v[i] = none[i / 8] >> (i % 8) & 1 ? DURATION_NONE : present[j++];
+        }
+        if (p != body_end)
+            return false;
+    }
+    return true;
+}
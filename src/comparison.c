@@ -0,0 +1,131 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "comparison.h"
+
+static Duration* durations(int count) {
+    Duration* d = malloc(sizeof(Duration) * (count > 0 ? count : 1));
+    for (int i = 0; i < count; ++i)
+        d[i] = DURATION_NONE;
+    return d;
+}
+
+static void update_best_possible(Comparisons* c) {
+    Duration rest = best_paths_remaining(&c->paths, c->reached);
+    if (c->reached == 0 || rest == DURATION_NONE)
+        c->best_possible = rest;
+    else
+        c->best_possible = c->run_splits[c->reached - 1] + rest;
+}
+
+void comparisons_init(Comparisons* c, History* history, const Duration* fallback_splits) {
+    int n = history->segment_count;
+    *c = (Comparisons){
+        .segment_count = n,
+        .pb = DURATION_NONE,
+        .pb_splits = durations(n),
+        .best_segments = durations(n),
+        .compare_splits = durations(n),
+        .compare_pb = true,
+        .run_splits = durations(n),
+        .deltas = durations(n),
+        .segment_deltas = durations(n),
+        .prev_best = durations(n)
+    };
+
+    int pb_attempt = -1;
+    for (int a = 0; a < history->attempt_count; ++a) {
+        Attempt* attempt = &history->attempts[a];
+        if (attempt->flags & ATTEMPT_COMPLETED && attempt->time < c->pb) {
+            c->pb = attempt->time;
+            pb_attempt = a;
+        }
+    }
+    if (pb_attempt >= 0) {
+        Duration time = 0;
+        for (int i = 0; i < n; ++i) {
+            Duration segment = history->segments[i][pb_attempt];
+            if (segment != DURATION_NONE)
+                c->pb_splits[i] = time += segment;
+        }
+    } else if (fallback_splits && n > 0 && fallback_splits[n - 1] > 0) {
+        for (int i = 0; i < n; ++i)
+            c->pb_splits[i] = fallback_splits[i] > 0 ? fallback_splits[i] : DURATION_NONE;
+        c->pb = fallback_splits[n - 1];
+    }
+
+    memcpy(c->compare_splits, c->pb_splits, sizeof(Duration) * n);
+
+    best_paths_init(&c->paths, history);
+    for (int i = 0; i < n; ++i)
+        c->best_segments[i] = best_paths_span(&c->paths, i, i + 1);
+    update_best_possible(c);
+}
+
+void comparisons_free(Comparisons* c) {
+    free(c->pb_splits);
+    free(c->best_segments);
+    free(c->compare_splits);
+    free(c->run_splits);
+    free(c->deltas);
+    free(c->segment_deltas);
+    free(c->prev_best);
+    best_paths_free(&c->paths);
+    *c = (Comparisons){0};
+}
+
+Duration comparisons_sum_of_best(const Comparisons* c) {
+    return best_paths_remaining(&c->paths, 0);
+}
+
+void comparisons_compare_to(Comparisons* c, const Duration* splits) {
+    c->compare_pb = !splits;
+    memcpy(c->compare_splits, splits ? splits : c->pb_splits, sizeof(Duration) * c->segment_count);
+    for (int i = 0; i < c->reached; ++i) {
+        Duration split = c->compare_splits[i];
+        c->deltas[i] = split == DURATION_NONE ? DURATION_NONE : c->run_splits[i] - split;
+    }
+}
+
+void comparisons_split(Comparisons* c, Duration time) {
+    int i = c->reached;
+    if (i >= c->segment_count)
+        return;
+    Duration segment = time - (i > 0 ? c->run_splits[i - 1] : 0);
+    Duration best = c->best_segments[i];
+    c->prev_best[i] = best;
+    c->segment_deltas[i] = best == DURATION_NONE ? DURATION_NONE : segment - best;
+    if (best_paths_offer(&c->paths, i, i + 1, segment))
+        c->best_segments[i] = segment;
+    c->deltas[i] = c->compare_splits[i] == DURATION_NONE ? DURATION_NONE : time - c->compare_splits[i];
+    c->run_splits[i] = time;
+    c->reached = i + 1;
+    update_best_possible(c);
+}
+
+void comparisons_undo(Comparisons* c) {
+    if (c->reached == 0)
+        return;
+    int i = --c->reached;
+    if (c->best_segments[i] != c->prev_best[i]) {
+        c->best_segments[i] = c->prev_best[i];
+        best_paths_set(&c->paths, i, i + 1, c->prev_best[i]);
+    }
+    update_best_possible(c);
+}
+
+void comparisons_reset(Comparisons* c) {
+    int n = c->segment_count;
+    if (n > 0 && c->reached == n && c->run_splits[n - 1] < c->pb) {
+        // Swap rather than copy; the run's old splits are overwritten
+        // as the next run splits.
+        Duration* pb_splits = c->pb_splits;
+        c->pb_splits = c->run_splits;
+        c->run_splits = pb_splits;
+        c->pb = c->pb_splits[n - 1];
+        if (c->compare_pb)
+            memcpy(c->compare_splits, c->pb_splits, sizeof(Duration) * n);
+    }
+    c->reached = 0;
+    update_best_possible(c);
+}
@@ -0,0 +1,83 @@
+#include <string.h>
+
+#include "duration.h"
+
+// Two digits at a time, so there's one division for every two.
+static const char digit_pairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint32_t pow10[10] = {
+    1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000, 1'000'000'000
+};
+
+static char* put_pair(char* p, uint32_t n) {
+    memcpy(p, &digit_pairs[n * 2], 2);
+    return p + 2;
+}
+
+// Write `n` with exactly `digits` digits, zero-padded.
+static char* put_padded(char* p, uint64_t n, int digits) {
+    char* end = p + digits;
+    char* q = end;
+    while (q - p >= 2) {
+        q -= 2;
+        memcpy(q, &digit_pairs[n % 100 * 2], 2);
+        n /= 100;
+    }
+    if (q > p)
+        *--q = '0' + n % 10;
+    return end;
+}
+
+static char* put_number(char* p, uint64_t n) {
+    int digits = 1;
+    for (uint64_t rest = n / 10; rest > 0; rest /= 10)
+        ++digits;
+    return put_padded(p, n, digits);
+}
+
+size_t duration_format(char* out, Duration d, int precision, unsigned flags) {
+    char* p = out;
+    // Negated unsigned, so that INT64_MIN works too.
+    uint64_t n = d < 0 ? -(uint64_t)d : (uint64_t)d;
+    if (d < 0)
+        *p++ = '-';
+    else if (flags & DurationSign)
+        *p++ = '+';
+
+    uint64_t total_seconds = n / NSEC_PER_SEC;
+    uint32_t fraction = n % NSEC_PER_SEC;
+    uint64_t hours = total_seconds / 3600;
+    uint32_t minutes = total_seconds / 60 % 60;
+    uint32_t seconds = total_seconds % 60;
+    if (hours > 0) {
+        p = put_number(p, hours);
+        *p++ = ':';
+        p = put_pair(p, minutes);
+        *p++ = ':';
+        p = put_pair(p, seconds);
+    } else if (minutes > 0 || !(flags & DurationShort)) {
+        p = put_number(p, minutes);
+        *p++ = ':';
+        p = put_pair(p, seconds);
+    } else {
+        p = put_number(p, seconds);
+    }
+
+    precision = precision < 0 ? 0 : precision > 9 ? 9 : precision;
+    if (precision > 0) {
+        *p++ = '.';
+        p = put_padded(p, fraction / pow10[9 - precision], precision);
+    }
+    *p = '\0';
+    return p - out;
+}
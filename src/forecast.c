@@ -0,0 +1,196 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "forecast.h"
+#include "sketch.h"
+
+struct ForecastJob {
+    unsigned id;       // the `started` count
+    int segment_count; // remaining
+    Duration budget;   // time left to beat the PB in
+    // FORECAST_QUANTILES times for each remaining segment, which the
+    // thread draws up from copies of their sketches.
+    Duration* quantiles;
+    Sketch sketches[];
+};
+
+typedef struct {
+    Forecast* forecast;
+    ForecastJob* job;
+    Duration deadline;
+    uint64_t seed;
+    // Per task.
+    uint64_t* hits;
+    uint64_t* samples;
+} Round;
+
+// Not `clock_now`, which is neither thread-safe nor always real time.
+static Duration now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return duration_from_timespec(ts);
+}
+
+// splitmix64
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+static void simulate(void* arg, int task) {
+    Round* r = arg;
+    ForecastJob* job = r->job;
+    uint64_t state = r->seed ^ ((uint64_t)task << 48);
+    uint64_t hits = 0;
+    uint64_t samples = 0;
+    // Check the time (and whether the estimate is still wanted) every
+    // few runs, finishing at least one batch.
+    do {
+        for (int n = 0; n < 64; ++n) {
+            Duration total = 0;
+            const Duration* quantiles = job->quantiles;
+            for (int i = 0; i < job->segment_count; ++i, quantiles += FORECAST_QUANTILES)
+                total += quantiles[(next_random(&state) >> 32) * FORECAST_QUANTILES >> 32];
+            hits += total < job->budget;
+        }
+        samples += 64;
+    } while (now() < r->deadline && __atomic_load_n(&r->forecast->started, __ATOMIC_RELAXED) == job->id);
+    r->hits[task] = hits;
+    r->samples[task] = samples;
+}
+
+static void publish(Forecast* f, unsigned id, uint64_t hits, uint64_t samples) {
+    // Only this thread writes, so the sequence can't change under it.
+    unsigned sequence = f->sequence;
+    __atomic_store_n(&f->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&f->estimate, id, __ATOMIC_RELAXED);
+    __atomic_store_n(&f->hits, hits, __ATOMIC_RELAXED);
+    __atomic_store_n(&f->samples, samples, __ATOMIC_RELAXED);
+    __atomic_store_n(&f->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+static void* forecast_run(void* arg) {
+    Forecast* f = arg;
+    ForecastJob* job = NULL;
+    uint64_t hits = 0;
+    uint64_t samples = 0;
+    int tasks = f->pool.thread_count + 1;
+    uint64_t* task_hits = malloc(sizeof(uint64_t) * tasks);
+    uint64_t* task_samples = malloc(sizeof(uint64_t) * tasks);
+
+    pthread_mutex_lock(&f->lock);
+    while (true) {
+        while (!f->stop && !f->pending && (!job || job->id != f->started || samples >= FORECAST_SAMPLES))
+            pthread_cond_wait(&f->wake, &f->lock);
+        if (f->stop)
+            break;
+        bool fresh = f->pending;
+        if (fresh) {
+            free(job);
+            job = f->pending;
+            f->pending = NULL;
+            hits = samples = 0;
+        }
+        pthread_mutex_unlock(&f->lock);
+        for (int i = 0; fresh && i < job->segment_count; ++i)
+            sketch_quantiles(&job->sketches[i], FORECAST_QUANTILES, job->quantiles + i * FORECAST_QUANTILES);
+
+        Round round = {
+            .forecast = f,
+            .job = job,
+            .deadline = now() + FORECAST_ROUND,
+            .seed = (uint64_t)job->id << 32 ^ samples,
+            .hits = task_hits,
+            .samples = task_samples
+        };
+        pool_run(&f->pool, tasks, simulate, &round);
+        for (int t = 0; t < tasks; ++t) {
+            hits += task_hits[t];
+            samples += task_samples[t];
+        }
+        publish(f, job->id, hits, samples);
+
+        pthread_mutex_lock(&f->lock);
+    }
+    pthread_mutex_unlock(&f->lock);
+    free(job);
+    free(task_hits);
+    free(task_samples);
+    return NULL;
+}
+
+void forecast_init(Forecast* f) {
+    *f = (Forecast){0};
+    pthread_mutex_init(&f->lock, NULL);
+    pthread_cond_init(&f->wake, NULL);
+    // This thread works in the pool too.
+    pool_init(&f->pool, -1);
+    pthread_create(&f->thread, NULL, forecast_run, f);
+}
+
+void forecast_free(Forecast* f) {
+    pthread_mutex_lock(&f->lock);
+    f->stop = true;
+    __atomic_store_n(&f->started, f->started + 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&f->wake);
+    pthread_mutex_unlock(&f->lock);
+    pthread_join(f->thread, NULL);
+    free(f->pending);
+    pool_free(&f->pool);
+    pthread_mutex_destroy(&f->lock);
+    pthread_cond_destroy(&f->wake);
+    *f = (Forecast){0};
+}
+
+void forecast_start(Forecast* f, History* h, int reached, Duration time, Duration pb) {
+    // The sketches are copied, since the history changes while they're
+    // being drawn from, and their quantiles are left to the thread.
+    ForecastJob* job = NULL;
+    int remaining = h->segment_count - reached;
+    for (int i = 0; i < remaining; ++i)
+        if (sketch_count(&h->sketches[reached + i]) == 0)
+            remaining = 0;
+    if (pb != DURATION_NONE && time != DURATION_NONE && remaining > 0) {
+        job = malloc(sizeof(ForecastJob) + (sizeof(Sketch) + sizeof(Duration) * FORECAST_QUANTILES) * remaining);
+        job->segment_count = remaining;
+        job->budget = pb - time;
+        job->quantiles = (Duration*)(job->sketches + remaining);
+        for (int i = 0; i < remaining; ++i)
+            sketch_copy(&job->sketches[i], &h->sketches[reached + i]);
+    }
+
+    pthread_mutex_lock(&f->lock);
+    unsigned id = f->started + 1;
+    __atomic_store_n(&f->started, id, __ATOMIC_RELAXED);
+    free(f->pending);
+    f->pending = job;
+    if (job) {
+        job->id = id;
+        pthread_cond_signal(&f->wake);
+    }
+    pthread_mutex_unlock(&f->lock);
+}
+
+bool forecast_read(Forecast* f, double* chance, uint64_t* samples) {
+    unsigned sequence;
+    unsigned estimate;
+    uint64_t hits;
+    uint64_t count;
+    do {
+        sequence = __atomic_load_n(&f->sequence, __ATOMIC_ACQUIRE);
+        estimate = __atomic_load_n(&f->estimate, __ATOMIC_RELAXED);
+        hits = __atomic_load_n(&f->hits, __ATOMIC_RELAXED);
+        count = __atomic_load_n(&f->samples, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (sequence & 1 || sequence != __atomic_load_n(&f->sequence, __ATOMIC_RELAXED));
+
+    if (estimate != f->started || count == 0)
+        return false;
+    *chance = (double)hits / count;
+    *samples = count;
+    return true;
+}
@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "history.h"
+
+// Shared by a history and its snapshots. It holds the buffers that the
+// history let go of while snapshots were taken, until the last one of
+// them (or the history) is done with it.
+typedef struct HistoryPin {
+    int refs;
+    void** retired;
+    int retired_count;
+    int retired_cap;
+} HistoryPin;
+
+static void release(HistoryPin* pin) {
+    if (__atomic_sub_fetch(&pin->refs, 1, __ATOMIC_ACQ_REL) > 0)
+        return;
+    for (int i = 0; i < pin->retired_count; ++i)
+        free(pin->retired[i]);
+    free(pin->retired);
+    free(pin);
+}
+
+// Whether a snapshot may still be reading `h`'s buffers.
+static bool pinned(History* h) {
+    if (!h->pin)
+        return false;
+    // Only `h` takes snapshots, so none can be taken while this runs.
+    if (__atomic_load_n(&h->pin->refs, __ATOMIC_ACQUIRE) > 1)
+        return true;
+    release(h->pin);
+    h->pin = NULL;
+    return false;
+}
+
+static void retire(HistoryPin* pin, void* buffer) {
+    if (pin->retired_count == pin->retired_cap) {
+        pin->retired_cap = pin->retired_cap ? pin->retired_cap * 2 : 16;
+        pin->retired = realloc(pin->retired, sizeof(void*) * pin->retired_cap);
+    }
+    pin->retired[pin->retired_count++] = buffer;
+}
+
+// Move a buffer to a bigger one, leaving the old one to the snapshots.
+static void* move(HistoryPin* pin, void* buffer, size_t used, size_t size) {
+    void* moved = malloc(size);
+    if (used > 0)
+        memcpy(moved, buffer, used);
+    retire(pin, buffer);
+    return moved;
+}
+
+void history_init(History* h, int segment_count) {
+    *h = (History){
+        .segment_count = segment_count,
+        .segments = calloc(segment_count > 0 ? segment_count : 1, sizeof(Duration*)),
+        .sketches = malloc(sizeof(Sketch) * (segment_count > 0 ? segment_count : 1))
+    };
+    for (int i = 0; i < segment_count; ++i)
+        sketch_init(&h->sketches[i]);
+}
+
+void history_free(History* h) {
+    if (pinned(h)) {
+        for (int i = 0; i < h->segment_count; ++i)
+            retire(h->pin, h->segments[i]);
+        retire(h->pin, h->attempts);
+        release(h->pin);
+    } else {
+        for (int i = 0; i < h->segment_count; ++i)
+            free(h->segments[i]);
+        free(h->attempts);
+    }
+    free(h->segments);
+    free(h->sketches);
+    *h = (History){0};
+}
+
+void history_reserve(History* h, int attempt_cap) {
+    if (attempt_cap <= h->attempt_cap)
+        return;
+    if (pinned(h)) {
+        for (int i = 0; i < h->segment_count; ++i) {
+            h->segments[i] = move(h->pin, h->segments[i], sizeof(Duration) * h->attempt_count,
+                                  sizeof(Duration) * attempt_cap);
+        }
+        h->attempts = move(h->pin, h->attempts, sizeof(Attempt) * h->attempt_count,
+                           sizeof(Attempt) * attempt_cap);
+    } else {
+        for (int i = 0; i < h->segment_count; ++i)
+            h->segments[i] = realloc(h->segments[i], sizeof(Duration) * attempt_cap);
+        h->attempts = realloc(h->attempts, sizeof(Attempt) * attempt_cap);
+    }
+    h->attempt_cap = attempt_cap;
+}
+
+void history_snapshot(History* h, History* snapshot) {
+    if (!h->pin) {
+        h->pin = calloc(1, sizeof(HistoryPin));
+        h->pin->refs = 1;
+    }
+    __atomic_add_fetch(&h->pin->refs, 1, __ATOMIC_RELAXED);
+    int n = h->segment_count > 0 ? h->segment_count : 1;
+    *snapshot = (History){
+        .segment_count = h->segment_count,
+        .attempt_count = h->attempt_count,
+        .attempt_cap = h->attempt_count,
+        .segments = malloc(sizeof(Duration*) * n),
+        .attempts = h->attempts,
+        // Updated in place as attempts are added, so copied.
+        .sketches = malloc(sizeof(Sketch) * n),
+        .pin = h->pin
+    };
+    memcpy(snapshot->segments, h->segments, sizeof(Duration*) * h->segment_count);
+    memcpy(snapshot->sketches, h->sketches, sizeof(Sketch) * h->segment_count);
+}
+
+void history_release_snapshot(History* snapshot) {
+    free(snapshot->segments);
+    free(snapshot->sketches);
+    if (snapshot->pin)
+        release(snapshot->pin);
+    *snapshot = (History){0};
+}
+
+void history_build_sketches(History* h) {
+    for (int i = 0; i < h->segment_count; ++i) {
+        sketch_init(&h->sketches[i]);
+        for (int a = 0; a < h->attempt_count; ++a)
+            sketch_add(&h->sketches[i], h->segments[i][a]);
+    }
+}
+
+static int history_next(History* h) {
+    if (h->attempt_count == h->attempt_cap)
+        history_reserve(h, h->attempt_cap ? h->attempt_cap * 2 : 64);
+    return h->attempt_count++;
+}
+
+int history_append(History* h, Attempt attempt, const Duration* segment_times) {
+    int a = history_next(h);
+    for (int i = 0; i < h->segment_count; ++i) {
+        h->segments[i][a] = segment_times[i];
+        sketch_add(&h->sketches[i], segment_times[i]);
+    }
+    h->attempts[a] = attempt;
+    return a;
+}
+
+int history_add(History* h, const Duration* split_times, int reached, Duration paused) {
+    int a = history_next(h);
+    Duration prev = 0;
+    Duration last = 0;
+    for (int i = 0; i < h->segment_count; ++i) {
+        Duration split = i < reached ? split_times[i] : DURATION_NONE;
+        h->segments[i][a] = split == DURATION_NONE ? DURATION_NONE : split - prev;
+        sketch_add(&h->sketches[i], h->segments[i][a]);
+        if (split != DURATION_NONE)
+            prev = last = split;
+    }
+    h->attempts[a] = (Attempt){
+        .time = last,
+        .paused = paused,
+        .reached = reached,
+        .flags = reached == h->segment_count ? ATTEMPT_COMPLETED : 0
+    };
+    return a;
+}
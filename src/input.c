@@ -0,0 +1,53 @@
+#include "clock.h"
+#include "input.h"
+
+// raylib statically links GLFW but doesn't ship its header,
+// so declare the few entry points that we chain onto.
+typedef struct GLFWwindow GLFWwindow;
+typedef void (*GLFWkeyfun)(GLFWwindow*, int, int, int, int);
+GLFWwindow* glfwGetCurrentContext(void);
+GLFWkeyfun  glfwSetKeyCallback(GLFWwindow* window, GLFWkeyfun callback);
+void        glfwWaitEventsTimeout(double timeout);
+
+#define GLFW_PRESS 1
+
+static GLFWkeyfun raylib_key_callback = NULL;
+
+static InputEvent queue[INPUT_QUEUE_SIZE] = {0};
+static int queue_head = 0;
+static int queue_len = 0;
+
+static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    // Stamp the press before anything else happens.
+    if (action == GLFW_PRESS) {
+        input_push((InputEvent){.key = key, .time = clock_now()});
+    }
+    // Let raylib keep its own key state (e.g. for the exit key).
+    if (raylib_key_callback)
+        raylib_key_callback(window, key, scancode, action, mods);
+}
+
+void input_init(void) {
+    raylib_key_callback = glfwSetKeyCallback(glfwGetCurrentContext(), key_callback);
+}
+
+bool input_push(InputEvent ev) {
+    if (queue_len == INPUT_QUEUE_SIZE)
+        return false;
+    queue[(queue_head + queue_len++) % INPUT_QUEUE_SIZE] = ev;
+    return true;
+}
+
+bool input_pop(InputEvent* ev) {
+    if (queue_len == 0)
+        return false;
+    *ev = queue[queue_head];
+    queue_head = (queue_head + 1) % INPUT_QUEUE_SIZE;
+    queue_len--;
+    return true;
+}
+
+void input_wait(double seconds) {
+    if (seconds > 0)
+        glfwWaitEventsTimeout(seconds);
+}
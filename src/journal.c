@@ -0,0 +1,162 @@
+#include <stdint.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "clock.h"
+#include "journal.h"
+
+#ifndef _WIN32
+static size_t file_size(size_t cap) {
+    return sizeof(JournalHeader) + cap * sizeof(JournalRecord);
+}
+
+// Double the file whenever the records pass half of it, so appending
+// never has to wait for it.
+static void* grow_file(void* arg) {
+    Journal* j = arg;
+    pthread_mutex_lock(&j->lock);
+    while (true) {
+        while (!j->grow && !j->stop)
+            pthread_cond_wait(&j->wake, &j->lock);
+        if (j->stop)
+            break;
+        pthread_mutex_unlock(&j->lock);
+
+        size_t cap = j->cap * 2 < JOURNAL_MAX_CAP ? j->cap * 2 : JOURNAL_MAX_CAP;
+        if (cap > j->cap && ftruncate(j->fd, file_size(cap)) == 0)
+            __atomic_store_n(&j->cap, cap, __ATOMIC_RELEASE);
+
+        pthread_mutex_lock(&j->lock);
+        __atomic_store_n(&j->grow, false, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&j->lock);
+    return NULL;
+}
+
+bool journal_open(Journal* j, str filename) {
+    *j = (Journal){.fd = open(filename.data, O_RDWR | O_CREAT, 0644)};
+    if (j->fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(j->fd, &st) != 0)
+        goto fail;
+    bool created = st.st_size == 0;
+    if (created && ftruncate(j->fd, file_size(JOURNAL_INITIAL_CAP)) != 0)
+        goto fail;
+    if (!created && (size_t)st.st_size < sizeof(JournalHeader))
+        goto fail;
+    size_t cap = created ? JOURNAL_INITIAL_CAP
+                         : ((size_t)st.st_size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+    j->cap = cap < JOURNAL_MAX_CAP ? cap : JOURNAL_MAX_CAP;
+    // Only the file's length is ever touched; pages past it fault.
+    void* ptr = mmap(NULL, file_size(JOURNAL_MAX_CAP), PROT_READ | PROT_WRITE, MAP_SHARED, j->fd, 0);
+    if (ptr == MAP_FAILED)
+        goto fail;
+    j->header = ptr;
+    j->records = (JournalRecord*)(j->header + 1);
+
+    if (created) {
+        memcpy(j->header->magic, JOURNAL_MAGIC, sizeof(j->header->magic));
+        j->header->version = JOURNAL_VERSION;
+        j->header->clock = clock_selected();
+    }
+    else if (memcmp(j->header->magic, JOURNAL_MAGIC, sizeof(j->header->magic)) != 0
+             || j->header->version != JOURNAL_VERSION || j->header->count > j->cap) {
+        munmap(j->header, file_size(JOURNAL_MAX_CAP));
+        goto fail;
+    }
+    // Nothing to recover, so whatever a long run grew it to can go.
+    else if (journal_find_run(j) == j->header->count) {
+        j->header->count = 0;
+        if (j->cap > JOURNAL_INITIAL_CAP && ftruncate(j->fd, file_size(JOURNAL_INITIAL_CAP)) == 0)
+            j->cap = JOURNAL_INITIAL_CAP;
+    }
+
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_cond_init(&j->wake, NULL);
+    pthread_create(&j->thread, NULL, grow_file, j);
+    return true;
+
+fail:
+    close(j->fd);
+    *j = (Journal){.fd = -1};
+    return false;
+}
+
+void journal_close(Journal* j) {
+    if (!j->header)
+        return;
+    pthread_mutex_lock(&j->lock);
+    j->stop = true;
+    pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+    pthread_join(j->thread, NULL);
+    pthread_mutex_destroy(&j->lock);
+    pthread_cond_destroy(&j->wake);
+
+    munmap(j->header, file_size(JOURNAL_MAX_CAP));
+    close(j->fd);
+    *j = (Journal){.fd = -1};
+}
+
+static void request_grow(Journal* j) {
+    if (__atomic_load_n(&j->grow, __ATOMIC_RELAXED))
+        return;
+    pthread_mutex_lock(&j->lock);
+    __atomic_store_n(&j->grow, true, __ATOMIC_RELAXED);
+    pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+}
+#else
+// No mmap on Windows; journaling is disabled there for now.
+bool journal_open(Journal* j, str filename) {
+    *j = (Journal){.fd = -1};
+    return false;
+}
+
+void journal_close(Journal* j) {}
+
+static void request_grow(Journal* j) {}
+#endif
+
+bool journal_append(Journal* j, JournalEventType type, int split_index, Duration time) {
+    uint64_t count = j->header->count;
+    size_t cap = __atomic_load_n(&j->cap, __ATOMIC_ACQUIRE);
+    if (count == cap)
+        return false;
+    j->records[count] = (JournalRecord){
+        .type = type,
+        .split_index = split_index,
+        .time = time
+    };
+    // Publish the record only once it's fully written.
+    __atomic_store_n(&j->header->count, count + 1, __ATOMIC_RELEASE);
+    // The run is over, so there's nothing left to recover.
+    if (type == JournalReset)
+        __atomic_store_n(&j->header->count, 0, __ATOMIC_RELEASE);
+    else if (count + 1 >= cap / 2)
+        request_grow(j);
+    return true;
+}
+
+size_t journal_count(Journal* j) {
+    return j->header ? __atomic_load_n(&j->header->count, __ATOMIC_ACQUIRE) : 0;
+}
+
+size_t journal_find_run(Journal* j) {
+    size_t count = journal_count(j);
+    // Runs are short compared to the whole journal, so scan backwards.
+    for (size_t i = count; i-- > 0;) {
+        if (j->records[i].type == JournalReset)
+            break;
+        if (j->records[i].type == JournalStart)
+            return i;
+    }
+    return count;
+}
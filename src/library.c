@@ -0,0 +1,246 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <fiesta/str.h>
+
+#include "library.h"
+#include "saver.h"
+#include "splitsbin.h"
+#include "splitter.h"
+
+void listing_free(Listing l) {
+    free(l.filename.data);
+    free(l.game.data);
+    free(l.category.data);
+}
+
+_GENERATE_ARRAY_IMPLEMENTATIONS(Listing, listing)
+
+static str copy_str(const char* p, int len) {
+    str s = {.data = malloc(len + 1), .len = len};
+    memcpy(s.data, p, len);
+    s.data[len] = '\0';
+    return s;
+}
+
+static int compare_str(str a, str b) {
+    int cmp = memcmp(a.data, b.data, a.len < b.len ? a.len : b.len);
+    return cmp ? cmp : (a.len > b.len) - (a.len < b.len);
+}
+
+static int compare_filename(const void* a, const void* b) {
+    return compare_str(((const Listing*)a)->filename, ((const Listing*)b)->filename);
+}
+
+static int compare_listing(const void* a, const void* b) {
+    const Listing* x = a;
+    const Listing* y = b;
+    int cmp = compare_str(x->game, y->game);
+    if (!cmp)
+        cmp = compare_str(x->category, y->category);
+    return cmp ? cmp : compare_str(x->filename, y->filename);
+}
+
+static int64_t mtime_of(const struct stat* st) {
+#ifdef _WIN32
+    return (int64_t)st->st_mtime * NSEC_PER_SEC;
+#else
+    return duration_from_timespec(st->st_mtim);
+#endif
+}
+
+// Read the index, sorted by filename. Missing or invalid indexes are empty.
+static Listings read_index(str filename) {
+    Listings listings = listings_create();
+    FILE* f = fopen(filename.data, "rb");
+    if (!f)
+        return listings;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buf = size > 0 ? malloc(size) : NULL;
+    bool ok = buf && fread(buf, 1, size, f) == (size_t)size;
+    fclose(f);
+
+    LibraryIndexHeader* h = (LibraryIndexHeader*)buf;
+    ok = ok && (size_t)size >= sizeof(*h) && memcmp(h->magic, LIBRARY_INDEX_MAGIC, sizeof(h->magic)) == 0
+         && h->version == LIBRARY_INDEX_VERSION
+         && (uint64_t)h->count * sizeof(LibraryIndexRecord) + h->strings_size == size - sizeof(*h);
+    if (!ok) {
+        free(buf);
+        return listings;
+    }
+    LibraryIndexRecord* records = (LibraryIndexRecord*)(h + 1);
+    const char* strings = (const char*)(records + h->count);
+    for (uint32_t i = 0; i < h->count; ++i) {
+        LibraryIndexRecord* r = &records[i];
+        if ((uint64_t)r->filename_offset + r->filename_len > h->strings_size
+            || (uint64_t)r->game_offset + r->game_len > h->strings_size
+            || (uint64_t)r->category_offset + r->category_len > h->strings_size)
+            continue;
+        listings_append(&listings, (Listing){
+            .filename = copy_str(strings + r->filename_offset, r->filename_len),
+            .game = copy_str(strings + r->game_offset, r->game_len),
+            .category = copy_str(strings + r->category_offset, r->category_len),
+            .segment_count = r->segment_count,
+            .attempt_count = r->attempt_count,
+            .pb = r->pb,
+            .mtime = r->mtime,
+            .size = r->size
+        });
+    }
+    free(buf);
+    qsort(listings.data, listings.len, sizeof(Listing), compare_filename);
+    return listings;
+}
+
+static void write_index(Saver* index, Listings listings) {
+    uint64_t strings_size = 0;
+    for (int i = 0; i < listings.len; ++i) {
+        Listing* l = &listings.data[i];
+        strings_size += l->filename.len + l->game.len + l->category.len + 3;
+    }
+    size_t size = sizeof(LibraryIndexHeader) + listings.len * sizeof(LibraryIndexRecord) + strings_size;
+    char* buf = calloc(size, 1);
+    LibraryIndexHeader* h = (LibraryIndexHeader*)buf;
+    *h = (LibraryIndexHeader){
+        .magic = LIBRARY_INDEX_MAGIC,
+        .version = LIBRARY_INDEX_VERSION,
+        .count = listings.len,
+        .strings_size = strings_size
+    };
+    LibraryIndexRecord* records = (LibraryIndexRecord*)(h + 1);
+    char* strings = (char*)(records + listings.len);
+    uint32_t offset = 0;
+    for (int i = 0; i < listings.len; ++i) {
+        Listing* l = &listings.data[i];
+        LibraryIndexRecord* r = &records[i];
+        *r = (LibraryIndexRecord){
+            .segment_count = l->segment_count,
+            .attempt_count = l->attempt_count,
+            .pb = l->pb,
+            .mtime = l->mtime,
+            .size = l->size
+        };
+        str fields[] = {l->filename, l->game, l->category};
+        uint32_t* offsets[] = {&r->filename_offset, &r->game_offset, &r->category_offset};
+        uint32_t* lens[] = {&r->filename_len, &r->game_len, &r->category_len};
+        for (int j = 0; j < 3; ++j) {
+            *offsets[j] = offset;
+            *lens[j] = fields[j].len;
+            memcpy(strings + offset, fields[j].data, fields[j].len);
+            offset += fields[j].len + 1;
+        }
+    }
+    saver_replace(index, buf, size);
+}
+
+// Read what the listing shows from the file itself.
+static bool read_listing(Listing* l) {
+    SplitsMap m;
+    if (splits_is_binary(l->filename)) {
+        if (!splits_map(&m, l->filename))
+            return false;
+        splits_map_summary(&m, &l->attempt_count, &l->pb);
+    } else {
+        if (!splits_load(&m, l->filename))
+            return false;
+        // Text files only have the split times.
+        l->attempt_count = 0;
+        l->pb = m.splits.len > 0 && m.splits.data[m.splits.len - 1].time > 0
+            ? m.splits.data[m.splits.len - 1].time
+            : DURATION_NONE;
+    }
+    l->game = copy_str(m.game.data, m.game.len);
+    l->category = copy_str(m.category.data, m.category.len);
+    l->segment_count = m.splits.len;
+    splits_release(&m);
+    return true;
+}
+
+// List `lib->dir`, reusing the listings in `cached` (sorted by filename)
+// for files that haven't changed, and write the index if anything did.
+static void scan(Library* lib, Listings cached) {
+    str dir = lib->dir;
+    lib->listings = listings_create();
+    bool changed = false;
+    int reused = 0;
+
+    DIR* d = opendir(dir.data);
+    struct dirent* ent;
+    while (d && (ent = readdir(d))) {
+        size_t len = strlen(ent->d_name);
+        if (len <= strlen(".splits") || strcmp(ent->d_name + len - strlen(".splits"), ".splits") != 0)
+            continue;
+        Listing l = {0};
+        if (strcmp(dir.data, ".") == 0)
+            l.filename = copy_str(ent->d_name, len);
+        else {
+            l.filename = (str){.data = malloc(dir.len + 1 + len + 1), .len = dir.len + 1 + len};
+            sprintf(l.filename.data, "%s/%s", dir.data, ent->d_name);
+        }
+        struct stat st;
+        if (stat(l.filename.data, &st) != 0 || !S_ISREG(st.st_mode)) {
+            listing_free(l);
+            continue;
+        }
+        l.mtime = mtime_of(&st);
+        l.size = st.st_size;
+
+        Listing* old = bsearch(&l, cached.data, cached.len, sizeof(Listing), compare_filename);
+        if (old && old->mtime == l.mtime && old->size == l.size) {
+            // Unchanged: take the cached listing's metadata. Its filename
+            // stays, since the cached listings are still searched.
+            l.game = old->game;
+            l.category = old->category;
+            l.segment_count = old->segment_count;
+            l.attempt_count = old->attempt_count;
+            l.pb = old->pb;
+            old->game = old->category = (str){0};
+            ++reused;
+        } else if (read_listing(&l)) {
+            changed = true;
+        } else {
+            listing_free(l);
+            continue;
+        }
+        listings_append(&lib->listings, l);
+    }
+    if (d)
+        closedir(d);
+
+    // Files that were removed change the index too.
+    if (changed || reused != cached.len)
+        write_index(&lib->index, lib->listings);
+    listings_free(cached);
+    qsort(lib->listings.data, lib->listings.len, sizeof(Listing), compare_listing);
+}
+
+void library_open(Library* lib, str dir, str index_filename) {
+    *lib = (Library){.dir = copy_str(dir.data, dir.len)};
+    saver_init(&lib->index, index_filename);
+    scan(lib, read_index(index_filename));
+}
+
+void library_refresh(Library* lib) {
+    Listings cached = lib->listings;
+    qsort(cached.data, cached.len, sizeof(Listing), compare_filename);
+    scan(lib, cached);
+}
+
+void library_free(Library* lib) {
+    saver_close(&lib->index);
+    listings_free(lib->listings);
+    free(lib->dir.data);
+    *lib = (Library){0};
+}
+
+int library_find(Library* lib, str filename) {
+    for (int i = 0; i < lib->listings.len; ++i)
+        if (compare_str(lib->listings.data[i].filename, filename) == 0)
+            return i;
+    return -1;
+}
@@ -0,0 +1,45 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <raylib.h>
+
+#include "loader.h"
+#include "splitsbin.h"
+
+static void* loader_run(void* arg) {
+    HistoryLoader* l = arg;
+    l->ok = splits_map_history(l->map, &l->history);
+    __atomic_store_n(&l->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+void history_loader_start(HistoryLoader* l, SplitsMap* map) {
+    *l = (HistoryLoader){.map = map, .active = true};
+    pthread_create(&l->thread, NULL, loader_run, l);
+}
+
+int history_loader_poll(HistoryLoader* l, History* h, bool wait) {
+    if (!l->active || (!wait && !__atomic_load_n(&l->done, __ATOMIC_ACQUIRE)))
+        return -1;
+    pthread_join(l->thread, NULL);
+    l->active = false;
+    if (!l->ok || l->history.segment_count != h->segment_count) {
+        TraceLog(LOG_WARNING, "LOADER: Failed to load the history");
+        history_free(&l->history);
+        return -1;
+    }
+
+    int loaded = l->history.attempt_count;
+    history_reserve(&l->history, loaded + h->attempt_count);
+    Duration* times = malloc(sizeof(Duration) * (h->segment_count + 1));
+    for (int a = 0; a < h->attempt_count; ++a) {
+        for (int i = 0; i < h->segment_count; ++i)
+            times[i] = h->segments[i][a];
+        history_append(&l->history, h->attempts[a], times);
+    }
+    free(times);
+    history_free(h);
+    *h = l->history;
+    l->history = (History){0};
+    return loaded;
+}
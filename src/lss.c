@@ -0,0 +1,588 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fiesta/file.h>
+#include <fiesta/str.h>
+
+#include "duration.h"
+#include "history.h"
+#include "lss.h"
+#include "splitter.h"
+
+#define LSS_READ_SIZE (256 * 1024)
+#define LSS_MAX_DEPTH 64
+
+// The only elements that matter; everything else is skipped.
+typedef enum {
+    ElemOther,
+    ElemRun,
+    ElemGameName,
+    ElemCategoryName,
+    ElemAttemptHistory,
+    ElemAttempt,
+    ElemSegments,
+    ElemSegment,
+    ElemName,
+    ElemSplitTimes,
+    ElemSplitTime,
+    ElemSegmentHistory,
+    ElemTime,
+    ElemRealTime,
+    ElemPauseTime
+} Elem;
+
+#define ELEM(name) {#name, sizeof(#name) - 1, Elem##name}
+
+static const struct {
+    const char* name;
+    int len;
+    Elem elem;
+} elem_names[] = {
+    ELEM(Run),
+    ELEM(GameName),
+    ELEM(CategoryName),
+    ELEM(AttemptHistory),
+    ELEM(Attempt),
+    ELEM(Segments),
+    ELEM(Segment),
+    ELEM(Name),
+    ELEM(SplitTimes),
+    ELEM(SplitTime),
+    ELEM(SegmentHistory),
+    ELEM(Time),
+    ELEM(RealTime),
+    ELEM(PauseTime),
+};
+
+typedef struct {
+    int id;
+    int attempt;
+} AttemptId;
+
+typedef struct {
+    Elem stack[LSS_MAX_DEPTH];
+    int depth;
+    bool is_run;
+
+    // Character data of the current Name/RealTime/PauseTime element.
+    char* text;
+    int text_len;
+    int text_cap;
+    bool capturing;
+
+    // Attempt ids in file order, and what's known about each.
+    int* attempt_ids;
+    Duration* attempt_paused;
+    int attempt_count;
+    int attempt_cap;
+    // Attempt ids and their indices, sorted by id, to look up the
+    // segment history's times by. `id_hint` is where the last lookup
+    // ended, since the times are usually in id order.
+    AttemptId* ids;
+    int id_hint;
+    // Inside the run's (first) <Segments>.
+    bool in_segments;
+
+    SplitsMap* map;
+    Splits* splits;
+    Duration** columns;
+    int column_cap;
+    str segment_name;
+    Duration segment_pb;
+    bool split_time_is_pb;
+    int time_id;
+    Duration time_value;
+} Importer;
+
+static Elem elem_lookup(const char* name, int len) {
+    for (size_t i = 0; i < sizeof(elem_names) / sizeof(elem_names[0]); ++i) {
+        if (elem_names[i].len == len && memcmp(elem_names[i].name, name, len) == 0)
+            return elem_names[i].elem;
+    }
+    return ElemOther;
+}
+
+static Elem parent(Importer* im, int up) {
+    int i = im->depth - 1 - up;
+    return i >= 0 && i < LSS_MAX_DEPTH ? im->stack[i] : ElemOther;
+}
+
+// Whether the open elements are exactly `path`, from the root down.
+static bool at_path(Importer* im, const Elem* path, int len) {
+    return im->depth == len && memcmp(im->stack, path, sizeof(Elem) * len) == 0;
+}
+
+#define AT(im, ...) at_path(im, (Elem[]){__VA_ARGS__}, sizeof((Elem[]){__VA_ARGS__}) / sizeof(Elem))
+
+static const char* find(const char* p, const char* end, const char* needle) {
+    size_t n = strlen(needle);
+    while ((p = memchr(p, needle[0], end - p)) && (size_t)(end - p) >= n) {
+        if (memcmp(p, needle, n) == 0)
+            return p;
+        ++p;
+    }
+    return NULL;
+}
+
+// Parse a .NET TimeSpan: [-][d.]hh:mm:ss[.fffffff]
+static Duration parse_time(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+        ++p;
+    bool negative = p < end && *p == '-';
+    if (negative)
+        ++p;
+    int64_t fields[4] = {0};
+    int count = 0;
+    int64_t days = 0;
+    Duration frac = 0;
+    while (p < end && count < 4) {
+        int64_t n = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+            n = n * 10 + (*p++ - '0');
+        fields[count++] = n;
+        if (p < end && *p == '.' && count == 1 && find(p, end, ":")) {
+            // "d." day prefix
+            days = n;
+            count = 0;
+            ++p;
+        }
+        else if (p < end && *p == '.') {
+            // Fraction of a second, up to nanosecond precision.
+            Duration scale = NSEC_PER_SEC / 10;
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p, scale /= 10)
+                frac += (*p - '0') * scale;
+            break;
+        }
+        else if (p < end && *p == ':')
+            ++p;
+        else
+            break;
+    }
+    if (count != 3)
+        return DURATION_NONE;
+    Duration d = days * 24 * NSEC_PER_HOUR + fields[0] * NSEC_PER_HOUR
+                 + fields[1] * NSEC_PER_MIN + fields[2] * NSEC_PER_SEC + frac;
+    return negative ? -d : d;
+}
+
+// Find an attribute's value in a start tag's attribute text.
+static bool attribute(const char* p, const char* end, const char* name, const char** value, int* len) {
+    size_t n = strlen(name);
+    for (; (p = find(p, end, name)); p += n) {
+        const char* q = p + n;
+        bool boundary = p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\n' || p[-1] == '\r';
+        if (!boundary || q + 1 >= end || q[0] != '=' || (q[1] != '"' && q[1] != '\''))
+            continue;
+        char quote = q[1];
+        const char* close = memchr(q + 2, quote, end - (q + 2));
+        if (!close)
+            return false;
+        *value = q + 2;
+        *len = close - (q + 2);
+        return true;
+    }
+    return false;
+}
+
+static int attribute_int(const char* p, const char* end, const char* name, int fallback) {
+    const char* value;
+    int len;
+    if (!attribute(p, end, name, &value, &len))
+        return fallback;
+    char buf[16] = {0};
+    memcpy(buf, value, len < 15 ? len : 15);
+    return atoi(buf);
+}
+
+static void text_append(Importer* im, const char* p, int len) {
+    if (im->text_len + len + 1 > im->text_cap) {
+        while (im->text_len + len + 1 > im->text_cap)
+            im->text_cap = im->text_cap ? im->text_cap * 2 : 256;
+        im->text = realloc(im->text, im->text_cap);
+    }
+    memcpy(im->text + im->text_len, p, len);
+    im->text_len += len;
+    im->text[im->text_len] = '\0';
+}
+
+// Decode the five predefined XML entities into a new string.
+// Decode a numeric character reference (&#NN; or &#xNN;) at `p` into
+// UTF-8 at `out`, which it's never shorter than. Returns the length of
+// the reference, or 0 if it isn't a valid one.
+static int decode_char_ref(const char* p, int len, char* out, int* out_len) {
+    if (len < 4 || p[1] != '#')
+        return 0;
+    bool hex = p[2] == 'x' || p[2] == 'X';
+    int i = hex ? 3 : 2;
+    uint32_t c = 0;
+    int digits = 0;
+    for (; i < len && p[i] != ';'; ++i, ++digits) {
+        int d = p[i] >= '0' && p[i] <= '9' ? p[i] - '0'
+              : hex && p[i] >= 'a' && p[i] <= 'f' ? p[i] - 'a' + 10
+              : hex && p[i] >= 'A' && p[i] <= 'F' ? p[i] - 'A' + 10
+              : -1;
+        if (d < 0 || c > 0x10FFFF)
+            return 0;
+        c = c * (hex ? 16 : 10) + d;
+    }
+    if (i == len || digits == 0 || c == 0 || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        return 0;
+    if (c < 0x80) {
+        out[0] = c;
+        *out_len = 1;
+    } else if (c < 0x800) {
+        out[0] = 0xC0 | c >> 6;
+        out[1] = 0x80 | (c & 0x3F);
+        *out_len = 2;
+    } else if (c < 0x10000) {
+        out[0] = 0xE0 | c >> 12;
+        out[1] = 0x80 | (c >> 6 & 0x3F);
+        out[2] = 0x80 | (c & 0x3F);
+        *out_len = 3;
+    } else {
+        out[0] = 0xF0 | c >> 18;
+        out[1] = 0x80 | (c >> 12 & 0x3F);
+        out[2] = 0x80 | (c >> 6 & 0x3F);
+        out[3] = 0x80 | (c & 0x3F);
+        *out_len = 4;
+    }
+    return i + 1;
+}
+
+static str decode_name(const char* p, int len) {
+    static const struct {
+        const char* entity;
+        char c;
+    } entities[] = {{"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}};
+    str s = {.data = malloc(len + 1), .len = 0};
+    for (int i = 0; i < len;) {
+        char c = p[i];
+        int skip = 1;
+        int n;
+        if (c == '&' && (skip = decode_char_ref(p + i, len - i, s.data + s.len, &n))) {
+            s.len += n;
+            i += skip;
+            continue;
+        }
+        skip = 1;
+        if (c == '&') {
+            for (size_t e = 0; e < sizeof(entities) / sizeof(entities[0]); ++e) {
+                int n = strlen(entities[e].entity);
+                if (len - i >= n && memcmp(p + i, entities[e].entity, n) == 0) {
+                    c = entities[e].c;
+                    skip = n;
+                    break;
+                }
+            }
+        }
+        s.data[s.len++] = c;
+        i += skip;
+    }
+    s.data[s.len] = '\0';
+    return s;
+}
+
+static int compare_ids(const void* a, const void* b) {
+    const AttemptId* x = a;
+    const AttemptId* y = b;
+    if (x->id != y->id)
+        return x->id < y->id ? -1 : 1;
+    return (x->attempt > y->attempt) - (x->attempt < y->attempt);
+}
+
+// Sorted by id rather than indexed by it, so that memory is bounded by
+// the attempts however sparse or large their ids are.
+static void build_id_index(Importer* im) {
+    im->ids = malloc(sizeof(AttemptId) * (im->attempt_count > 0 ? im->attempt_count : 1));
+    for (int i = 0; i < im->attempt_count; ++i)
+        im->ids[i] = (AttemptId){.id = im->attempt_ids[i], .attempt = i};
+    qsort(im->ids, im->attempt_count, sizeof(AttemptId), compare_ids);
+}
+
+// Find the attempt with `id` (the last one, if several share it), or -1.
+static int find_attempt(Importer* im, int id) {
+    int n = im->attempt_count;
+    int i = im->id_hint + 1;
+    // Usually the next id along.
+    if (!(i < n && im->ids[i].id == id && (i + 1 == n || im->ids[i + 1].id != id))) {
+        int lo = 0;
+        int hi = n;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (im->ids[mid].id <= id)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        i = lo - 1;
+        if (i < 0 || im->ids[i].id != id)
+            return -1;
+    }
+    im->id_hint = i;
+    return im->ids[i].attempt;
+}
+
+static void start_element(Importer* im, Elem elem, const char* attrs, const char* attrs_end) {
+    switch (elem) {
+        case ElemRun:
+            if (im->depth == 0)
+                im->is_run = true;
+            break;
+        case ElemAttempt:
+            // The columns are sized by the attempts seen before <Segments>,
+            // so any that come after it are ignored.
+            if (!AT(im, ElemRun, ElemAttemptHistory) || im->ids)
+                break;
+            if (im->attempt_count == im->attempt_cap) {
+                im->attempt_cap = im->attempt_cap ? im->attempt_cap * 2 : 1024;
+                im->attempt_ids = realloc(im->attempt_ids, sizeof(int) * im->attempt_cap);
+                im->attempt_paused = realloc(im->attempt_paused, sizeof(Duration) * im->attempt_cap);
+            }
+            im->attempt_ids[im->attempt_count] = attribute_int(attrs, attrs_end, "id", 0);
+            im->attempt_paused[im->attempt_count++] = 0;
+            break;
+        case ElemSegments:
+            if (AT(im, ElemRun) && !im->ids) {
+                build_id_index(im);
+                im->in_segments = true;
+            }
+            break;
+        case ElemSegment: {
+            if (!AT(im, ElemRun, ElemSegments) || !im->in_segments)
+                break;
+            int i = im->splits->len;
+            if (i == im->column_cap) {
+                im->column_cap = im->column_cap ? im->column_cap * 2 : 64;
+                im->columns = realloc(im->columns, sizeof(Duration*) * im->column_cap);
+            }
+            im->columns[i] = malloc(sizeof(Duration) * (im->attempt_count > 0 ? im->attempt_count : 1));
+            for (int a = 0; a < im->attempt_count; ++a)
+                im->columns[i][a] = DURATION_NONE;
+            im->segment_name = (str){0};
+            im->segment_pb = 0;
+            break;
+        }
+        case ElemSplitTime: {
+            const char* value;
+            int len;
+            im->split_time_is_pb = attribute(attrs, attrs_end, "name", &value, &len)
+                                   && len == 13 && memcmp(value, "Personal Best", 13) == 0;
+            break;
+        }
+        case ElemTime:
+            im->time_id = attribute_int(attrs, attrs_end, "id", 0);
+            im->time_value = DURATION_NONE;
+            break;
+        case ElemName:
+        case ElemGameName:
+        case ElemCategoryName:
+        case ElemRealTime:
+        case ElemPauseTime:
+            im->capturing = true;
+            im->text_len = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+static void end_element(Importer* im, Elem elem) {
+    // `parent(im, 0)` is the element being closed.
+    Elem up = parent(im, 1);
+    switch (elem) {
+        case ElemName:
+            if (AT(im, ElemRun, ElemSegments, ElemSegment, ElemName) && !im->segment_name.data)
+                im->segment_name = decode_name(im->text, im->text_len);
+            break;
+        case ElemGameName:
+            if (up == ElemRun && !im->map->game.data)
+                im->map->game = decode_name(im->text, im->text_len);
+            break;
+        case ElemCategoryName:
+            if (up == ElemRun && !im->map->category.data)
+                im->map->category = decode_name(im->text, im->text_len);
+            break;
+        case ElemRealTime: {
+            Duration time = parse_time(im->text, im->text + im->text_len);
+            if (up == ElemTime && parent(im, 2) == ElemSegmentHistory)
+                im->time_value = time;
+            else if (AT(im, ElemRun, ElemSegments, ElemSegment, ElemSplitTimes, ElemSplitTime, ElemRealTime)
+                     && im->split_time_is_pb && time != DURATION_NONE)
+                im->segment_pb = time;
+            break;
+        }
+        case ElemPauseTime:
+            if (AT(im, ElemRun, ElemAttemptHistory, ElemAttempt, ElemPauseTime) && !im->ids && im->attempt_count > 0) {
+                Duration time = parse_time(im->text, im->text + im->text_len);
+                if (time != DURATION_NONE)
+                    im->attempt_paused[im->attempt_count - 1] = time;
+            }
+            break;
+        case ElemTime: {
+            // Ids that aren't in the attempt history (e.g. the negative ids
+            // LiveSplit gives imported best segments) are dropped.
+            if (!AT(im, ElemRun, ElemSegments, ElemSegment, ElemSegmentHistory, ElemTime))
+                break;
+            int a = find_attempt(im, im->time_id);
+            if (a >= 0)
+                im->columns[im->splits->len][a] = im->time_value;
+            break;
+        }
+        case ElemSegments:
+            if (AT(im, ElemRun, ElemSegments))
+                im->in_segments = false;
+            break;
+        case ElemSegment:
+            // Only the run's own segments have a column started for them.
+            if (!AT(im, ElemRun, ElemSegments, ElemSegment) || !im->in_segments)
+                break;
+            if (!im->segment_name.data)
+                im->segment_name = decode_name("", 0);
+            splits_append(im->splits, split_create(im->segment_name, im->segment_pb));
+            break;
+        default:
+            break;
+    }
+    im->capturing = false;
+}
+
+// Handle one tag (without its angle brackets).
+static void tag(Importer* im, const char* p, const char* end) {
+    bool closing = *p == '/';
+    bool self_closing = end > p && end[-1] == '/';
+    if (closing)
+        ++p;
+    if (self_closing)
+        --end;
+    const char* name_end = p;
+    while (name_end < end && *name_end != ' ' && *name_end != '\t' && *name_end != '\n' && *name_end != '\r')
+        ++name_end;
+    Elem elem = elem_lookup(p, name_end - p);
+
+    if (!closing) {
+        start_element(im, elem, name_end, end);
+        if (im->depth < LSS_MAX_DEPTH)
+            im->stack[im->depth] = elem;
+        ++im->depth;
+    }
+    if (closing || self_closing) {
+        end_element(im, elem);
+        --im->depth;
+    }
+}
+
+// Parse as much of the buffer as possible, returning
+// how far it got. Only complete tokens are consumed.
+static const char* parse(Importer* im, const char* p, const char* end, bool eof) {
+    while (p < end) {
+        if (*p != '<') {
+            const char* lt = memchr(p, '<', end - p);
+            if (!lt && !eof)
+                return p;
+            if (!lt)
+                lt = end;
+            if (im->capturing)
+                text_append(im, p, lt - p);
+            p = lt;
+            continue;
+        }
+
+        const char* close;
+        if (end - p >= 4 && memcmp(p, "<!--", 4) == 0) {
+            if (!(close = find(p + 4, end, "-->")))
+                return p;
+            p = close + 3;
+        }
+        else if (end - p >= 9 && memcmp(p, "<![CDATA[", 9) == 0) {
+            if (!(close = find(p + 9, end, "]]>")))
+                return p;
+            if (im->capturing)
+                text_append(im, p + 9, close - (p + 9));
+            p = close + 3;
+        }
+        else if (end - p >= 2 && (p[1] == '?' || p[1] == '!')) {
+            if (!(close = memchr(p, '>', end - p)))
+                return p;
+            p = close + 1;
+        }
+        else {
+            if (!(close = memchr(p, '>', end - p)))
+                return p;
+            tag(im, p + 1, close);
+            p = close + 1;
+        }
+    }
+    return p;
+}
+
+static void finish(Importer* im, History* h) {
+    int segment_count = im->splits->len;
+    *h = (History){
+        .segment_count = segment_count,
+        .attempt_count = im->attempt_count,
+        .attempt_cap = im->attempt_count,
+        .segments = im->columns ? im->columns : calloc(1, sizeof(Duration*)),
+        .attempts = calloc(im->attempt_count > 0 ? im->attempt_count : 1, sizeof(Attempt)),
+        .sketches = malloc(sizeof(Sketch) * (segment_count > 0 ? segment_count : 1))
+    };
+    // Segment-major, so that every pass is over one contiguous column.
+    for (int i = 0; i < segment_count; ++i) {
+        Duration* column = h->segments[i];
+        for (int a = 0; a < h->attempt_count; ++a) {
+            if (column[a] != DURATION_NONE) {
+                h->attempts[a].time += column[a];
+                h->attempts[a].reached = i + 1;
+            }
+        }
+    }
+    for (int a = 0; a < h->attempt_count; ++a) {
+        h->attempts[a].paused = im->attempt_paused[a];
+        if (segment_count > 0 && h->attempts[a].reached == segment_count)
+            h->attempts[a].flags |= ATTEMPT_COMPLETED;
+    }
+    history_build_sketches(h);
+    im->columns = NULL;
+}
+
+bool lss_import(str filename, SplitsMap* map, History* history) {
+    File file = file_open(filename, FileRead | FileBinary);
+    if (!file_is_open(file))
+        return false;
+
+    *map = (SplitsMap){.splits = splits_create()};
+    Importer im = {.map = map, .splits = &map->splits};
+    size_t buf_cap = LSS_READ_SIZE;
+    char* buf = malloc(buf_cap);
+    size_t buf_len = 0;
+    size_t n;
+    do {
+        // Only grow when a single token doesn't fit.
+        if (buf_len == buf_cap)
+            buf = realloc(buf, buf_cap *= 2);
+        n = fread(buf + buf_len, 1, buf_cap - buf_len, file.ptr);
+        buf_len += n;
+        const char* p = parse(&im, buf, buf + buf_len, n == 0);
+        buf_len -= p - buf;
+        memmove(buf, p, buf_len);
+    } while (n > 0);
+    free(buf);
+    file_close(&file);
+
+    bool ok = im.is_run;
+    if (ok)
+        finish(&im, history);
+    else {
+        for (int i = 0; i < map->splits.len; ++i)
+            free(im.columns[i]);
+        free(im.columns);
+        splits_release(map);
+        *history = (History){0};
+    }
+    free(im.text);
+    free(im.attempt_ids);
+    free(im.attempt_paused);
+    free(im.ids);
+    return ok;
+}
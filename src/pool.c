@@ -0,0 +1,99 @@
+#include <pthread.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "pool.h"
+
+// Claim and run tasks of the current batch until there are none left.
+// Called with the lock held.
+static void work(Pool* p) {
+    while (p->next < p->task_count) {
+        int task = p->next++;
+        pthread_mutex_unlock(&p->lock);
+        p->fn(p->arg, task);
+        pthread_mutex_lock(&p->lock);
+        if (++p->finished == p->task_count)
+            pthread_cond_broadcast(&p->done);
+    }
+}
+
+static void* pool_worker(void* arg) {
+    Pool* p = arg;
+    unsigned seen = 0;
+    pthread_mutex_lock(&p->lock);
+    while (true) {
+        while (!p->stop && p->generation == seen)
+            pthread_cond_wait(&p->wake, &p->lock);
+        if (p->stop)
+            break;
+        seen = p->generation;
+        work(p);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+static int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? n : 1;
+#endif
+}
+
+void pool_init(Pool* p, int thread_count) {
+    if (thread_count <= 0)
+        thread_count = cpu_count() - 1 + thread_count;
+    if (thread_count < 0)
+        thread_count = 0;
+    *p = (Pool){
+        .threads = malloc(sizeof(pthread_t) * (thread_count > 0 ? thread_count : 1)),
+        .thread_count = thread_count
+    };
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->wake, NULL);
+    pthread_cond_init(&p->done, NULL);
+    for (int i = 0; i < thread_count; ++i)
+        pthread_create(&p->threads[i], NULL, pool_worker, p);
+}
+
+void pool_free(Pool* p) {
+    pthread_mutex_lock(&p->lock);
+    p->stop = true;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+    for (int i = 0; i < p->thread_count; ++i)
+        pthread_join(p->threads[i], NULL);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->wake);
+    pthread_cond_destroy(&p->done);
+    free(p->threads);
+    *p = (Pool){0};
+}
+
+void pool_run(Pool* p, int task_count, PoolTask fn, void* arg) {
+    if (!p || p->thread_count == 0 || task_count <= 1) {
+        for (int i = 0; i < task_count; ++i)
+            fn(arg, i);
+        return;
+    }
+    pthread_mutex_lock(&p->lock);
+    p->fn = fn;
+    p->arg = arg;
+    p->task_count = task_count;
+    p->next = 0;
+    p->finished = 0;
+    ++p->generation;
+    pthread_cond_broadcast(&p->wake);
+    work(p);
+    while (p->finished < p->task_count)
+        pthread_cond_wait(&p->done, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+}
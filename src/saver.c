@@ -0,0 +1,217 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#endif
+
+#include <fiesta/str.h>
+#include <raylib.h>
+
+#include "saver.h"
+
+#ifdef _WIN32
+#define fsync _commit
+#define O_FLAGS O_BINARY
+#else
+#define O_FLAGS 0
+#endif
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+// A rename is only durable once the directory it's in has been synced.
+static void sync_parent(const char* filename) {
+    const char* slash = strrchr(filename, '/');
+    size_t len = slash ? (slash == filename ? 1 : (size_t)(slash - filename)) : 1;
+    char* dir = malloc(len + 1);
+    memcpy(dir, slash ? filename : ".", len);
+    dir[len] = '\0';
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0 || fsync(fd) != 0)
+        TraceLog(LOG_WARNING, "SAVER: Failed to sync %s after saving %s", dir, filename);
+    if (fd >= 0)
+        close(fd);
+    free(dir);
+}
+#endif
+
+bool save_atomic(const char* filename, const void* data, size_t size) {
+    size_t len = strlen(filename);
+    char* tmp = malloc(len + sizeof(".tmp"));
+    memcpy(tmp, filename, len);
+    memcpy(tmp + len, ".tmp", sizeof(".tmp"));
+
+    bool ok = false;
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_FLAGS, 0644);
+    if (fd < 0)
+        goto done;
+    ok = write_all(fd, data, size) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+#ifdef _WIN32
+    ok = ok && MoveFileExA(tmp, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && rename(tmp, filename) == 0;
+    if (ok)
+        sync_parent(filename);
+#endif
+    if (!ok)
+        unlink(tmp);
+
+done:
+    free(tmp);
+    return ok;
+}
+
+bool save_append(const char* filename, const void* data, size_t size) {
+    int fd = open(filename, O_WRONLY | O_APPEND | O_FLAGS);
+    if (fd < 0)
+        return false;
+    bool ok = write_all(fd, data, size) && fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+}
+
+static void* saver_run(void* arg) {
+    Saver* s = arg;
+    pthread_mutex_lock(&s->lock);
+    while (true) {
+        while (!s->data && !s->encode && !s->append_size && !s->stop)
+            pthread_cond_wait(&s->wake, &s->lock);
+        if (!s->data && !s->encode && !s->append_size)
+            break;
+        // Take one whole-file save, or else all pending appends.
+        void* data = s->data;
+        size_t size = s->size;
+        SaverEncode encode = s->encode;
+        void* arg = s->arg;
+        bool replace = data || encode;
+        if (replace) {
+            s->data = NULL;
+            s->encode = NULL;
+        } else {
+            data = s->append;
+            size = s->append_size;
+            s->append = NULL;
+            s->append_size = s->append_cap = 0;
+        }
+        s->writing = true;
+        pthread_mutex_unlock(&s->lock);
+
+        if (encode)
+            data = encode(arg, &size);
+        bool ok = data && (replace ? save_atomic(s->filename, data, size)
+                                   : save_append(s->filename, data, size));
+        if (!ok)
+            TraceLog(LOG_WARNING, "SAVE: Failed to save %s", s->filename);
+        free(data);
+
+        struct stat st = {0};
+        stat(s->filename, &st);
+        pthread_mutex_lock(&s->lock);
+        s->written = st;
+        s->writing = false;
+        if (replace && ok)
+            s->replaced_size = size;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+void saver_init(Saver* s, str filename) {
+    *s = (Saver){.filename = malloc(filename.len + 1)};
+    memcpy(s->filename, filename.data, filename.len + 1);
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+    pthread_create(&s->thread, NULL, saver_run, s);
+}
+
+// Drop the queued whole-file save and appends. Called with the lock held.
+static void drop_queued(Saver* s) {
+    free(s->data);
+    if (s->encode)
+        s->drop(s->arg);
+    free(s->append);
+    s->data = NULL;
+    s->encode = NULL;
+    s->append = NULL;
+    s->append_size = s->append_cap = 0;
+}
+
+void saver_replace(Saver* s, void* data, size_t size) {
+    pthread_mutex_lock(&s->lock);
+    drop_queued(s);
+    s->data = data;
+    s->size = size;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void saver_replace_encoded(Saver* s, SaverEncode encode, SaverDrop drop, void* arg) {
+    pthread_mutex_lock(&s->lock);
+    drop_queued(s);
+    s->encode = encode;
+    s->drop = drop;
+    s->arg = arg;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+size_t saver_replaced_size(Saver* s) {
+    pthread_mutex_lock(&s->lock);
+    size_t size = s->replaced_size;
+    pthread_mutex_unlock(&s->lock);
+    return size;
+}
+
+void saver_append(Saver* s, const void* data, size_t size) {
+    pthread_mutex_lock(&s->lock);
+    if (s->append_size + size > s->append_cap) {
+        while (s->append_size + size > s->append_cap)
+            s->append_cap = s->append_cap ? s->append_cap * 2 : 4096;
+        s->append = realloc(s->append, s->append_cap);
+    }
+    memcpy(s->append + s->append_size, data, size);
+    s->append_size += size;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+bool saver_wrote(Saver* s, const struct stat* st) {
+    pthread_mutex_lock(&s->lock);
+    bool wrote = s->writing
+        || (st->st_ino == s->written.st_ino && st->st_size == s->written.st_size
+#ifdef _WIN32
+            && st->st_mtime == s->written.st_mtime);
+#else
+            && st->st_mtim.tv_sec == s->written.st_mtim.tv_sec
+            && st->st_mtim.tv_nsec == s->written.st_mtim.tv_nsec);
+#endif
+    pthread_mutex_unlock(&s->lock);
+    return wrote;
+}
+
+void saver_close(Saver* s) {
+    pthread_mutex_lock(&s->lock);
+    s->stop = true;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+    free(s->filename);
+}
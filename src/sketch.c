@@ -0,0 +1,207 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sketch.h"
+
+static const double pi = 3.14159265358979323846;
+
+void sketch_init(Sketch* s) {
+    s->count = 0;
+    s->buffered = 0;
+    s->total = 0;
+    s->min = DURATION_NONE;
+    s->max = INT64_MIN;
+}
+
+void sketch_copy(Sketch* dst, const Sketch* src) {
+    dst->count = src->count;
+    dst->buffered = src->buffered;
+    dst->total = src->total;
+    dst->min = src->min;
+    dst->max = src->max;
+    memcpy(dst->centroids, src->centroids, sizeof(SketchCentroid) * src->count);
+    memcpy(dst->buffer, src->buffer, sizeof(Duration) * src->buffered);
+}
+
+void sketch_add(Sketch* s, Duration time) {
+    if (time == DURATION_NONE)
+        return;
+    if (s->buffered == SKETCH_BUFFER)
+        sketch_flush(s);
+    s->buffer[s->buffered++] = time;
+    s->min = time < s->min ? time : s->min;
+    s->max = time > s->max ? time : s->max;
+}
+
+// The scale function: centroids may span at most 1 in k, which changes
+// fastest near q = 0 and q = 1. Its range is SKETCH_COMPRESSION / 2, so
+// there are at most about that many centroids.
+static double scale(double q) {
+    return SKETCH_COMPRESSION / (2 * pi) * asin(2 * q - 1);
+}
+
+// The largest quantile that a centroid starting at `q` may reach.
+static double quantile_limit(double q) {
+    double k = scale(q) + 1;
+    if (k >= SKETCH_COMPRESSION / 4.0)
+        return 1;
+    return (sin(k * (2 * pi) / SKETCH_COMPRESSION) + 1) / 2;
+}
+
+// Sorting the buffer is most of the cost of adding a time. Comparison
+// sorts mispredict about every other branch on random times, so this is
+// a radix sort, a byte at a time over only the bits in which the times
+// differ.
+static void sort_durations(Duration* v, int n) {
+    uint64_t lo = v[0];
+    uint64_t hi = v[0];
+    for (int i = 1; i < n; ++i) {
+        lo = (Duration)v[i] < (Duration)lo ? (uint64_t)v[i] : lo;
+        hi = (Duration)v[i] > (Duration)hi ? (uint64_t)v[i] : hi;
+    }
+    uint64_t range = hi - lo;
+    Duration scratch[SKETCH_BUFFER];
+    Duration* from = v;
+    Duration* to = scratch;
+    for (int shift = 0; shift < 64 && range >> shift != 0; shift += 8) {
+        int offsets[256] = {0};
+        for (int i = 0; i < n; ++i)
+            ++offsets[((uint64_t)from[i] - lo) >> shift & 0xff];
+        for (int d = 0, sum = 0; d < 256; ++d) {
+            int count = offsets[d];
+            offsets[d] = sum;
+            sum += count;
+        }
+        for (int i = 0; i < n; ++i)
+            to[offsets[((uint64_t)from[i] - lo) >> shift & 0xff]++] = from[i];
+        Duration* t = from;
+        from = to;
+        to = t;
+    }
+    if (from != v)
+        memcpy(v, from, sizeof(Duration) * n);
+}
+
+void sketch_flush(Sketch* s) {
+    if (s->buffered == 0)
+        return;
+    sort_durations(s->buffer, s->buffered);
+    // Both the buffer and the centroids are sorted, so merge them.
+    SketchCentroid merged[SKETCH_CENTROIDS + SKETCH_BUFFER];
+    int n = 0;
+    for (int i = 0, b = 0; i < s->count || b < s->buffered;) {
+        if (b == s->buffered || (i < s->count && s->centroids[i].mean <= s->buffer[b]))
+            merged[n++] = s->centroids[i++];
+        else
+            merged[n++] = (SketchCentroid){.mean = s->buffer[b++], .weight = 1};
+    }
+    s->total += s->buffered;
+    s->buffered = 0;
+
+    // Greedily combine neighbours for as long as they fit within the limit.
+    SketchCentroid current = merged[0];
+    double before = 0;
+    double limit = quantile_limit(0);
+    s->count = 0;
+    for (int i = 1; i < n; ++i) {
+        if ((before + current.weight + merged[i].weight) / s->total <= limit) {
+            current.weight += merged[i].weight;
+            current.mean += (merged[i].mean - current.mean) * merged[i].weight / current.weight;
+        } else {
+            s->centroids[s->count++] = current;
+            before += current.weight;
+            limit = quantile_limit(before / s->total);
+            current = merged[i];
+        }
+    }
+    s->centroids[s->count++] = current;
+}
+
+int64_t sketch_count(Sketch* s) {
+    return (int64_t)s->total + s->buffered;
+}
+
+static double interpolate(double x0, double y0, double x1, double y1, double x) {
+    return x1 > x0 ? y0 + (y1 - y0) * (x - x0) / (x1 - x0) : y1;
+}
+
+// Walks the centroids for increasing ranks. Ranks go from 0 (min) to
+// total - 1 (max), and each centroid's mean is taken to be at the middle
+// of the ranks it covers.
+typedef struct {
+    int index;
+    double before; // weight of the centroids before `index`
+    double prev_rank;
+    double prev_value;
+} Cursor;
+
+static Duration lookup(Sketch* s, Cursor* c, double rank) {
+    double last = s->total - 1;
+    if (rank <= 0)
+        return s->min;
+    if (rank >= last)
+        return s->max;
+    for (; c->index < s->count; ++c->index) {
+        SketchCentroid* centroid = &s->centroids[c->index];
+        double center = c->before + (centroid->weight - 1) / 2;
+        if (rank < center)
+            return llround(interpolate(c->prev_rank, c->prev_value, center, centroid->mean, rank));
+        c->prev_rank = center;
+        c->prev_value = centroid->mean;
+        c->before += centroid->weight;
+    }
+    return llround(interpolate(c->prev_rank, c->prev_value, last, s->max, rank));
+}
+
+Duration sketch_quantile(Sketch* s, double q) {
+    sketch_flush(s);
+    if (s->total == 0)
+        return DURATION_NONE;
+    Cursor c = {.prev_value = s->min};
+    return lookup(s, &c, q * (s->total - 1));
+}
+
+void sketch_quantiles(Sketch* s, int count, Duration* out) {
+    sketch_flush(s);
+    Cursor c = {.prev_value = s->min};
+    for (int i = 0; i < count; ++i)
+        out[i] = s->total == 0 ? DURATION_NONE : lookup(s, &c, (i + 0.5) / count * (s->total - 1));
+}
+
+size_t sketch_encoded_size(Sketch* s) {
+    sketch_flush(s);
+    return sizeof(SketchRecord) + sizeof(SketchCentroid) * s->count;
+}
+
+size_t sketch_encode(Sketch* s, void* out) {
+    size_t size = sketch_encoded_size(s);
+    SketchRecord* r = out;
+    *r = (SketchRecord){.min = s->min, .max = s->max, .count = s->count};
+    memcpy(r + 1, s->centroids, sizeof(SketchCentroid) * s->count);
+    return size;
+}
+
+size_t sketch_decode(Sketch* s, const void* data, size_t size) {
+    const SketchRecord* r = data;
+    if (size < sizeof(*r) || r->count > SKETCH_CENTROIDS
+        || size - sizeof(*r) < sizeof(SketchCentroid) * r->count)
+        return 0;
+    sketch_init(s);
+    const SketchCentroid* centroids = (const SketchCentroid*)(r + 1);
+    for (uint32_t i = 0; i < r->count; ++i) {
+        // Merging relies on the centroids being sorted.
+        if (!(centroids[i].weight >= 1) || (i > 0 && !(centroids[i].mean >= centroids[i - 1].mean)))
+            return 0;
+        s->total += centroids[i].weight;
+    }
+    if (r->count > 0 && r->min > r->max)
+        return 0;
+    memcpy(s->centroids, centroids, sizeof(SketchCentroid) * r->count);
+    s->count = r->count;
+    if (r->count > 0) {
+        s->min = r->min;
+        s->max = r->max;
+    }
+    return sizeof(*r) + sizeof(SketchCentroid) * r->count;
+}
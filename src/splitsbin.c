@@ -0,0 +1,421 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <fiesta/file.h>
+#include <fiesta/str.h>
+
+#include "column.h"
+#include "saver.h"
+#include "sketch.h"
+#include "splitsbin.h"
+#include "splitter.h"
+
+static size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+#ifndef _WIN32
+static bool map_file(SplitsMap* m, str filename) {
+    int fd = open(filename.data, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return false;
+    m->data = ptr;
+    m->size = st.st_size;
+    m->mapped = true;
+    return true;
+}
+
+static void unmap_file(SplitsMap* m) {
+    if (m->mapped)
+        munmap(m->data, m->size);
+    else
+        free(m->data);
+}
+#else
+// No mmap on Windows; read the whole file in one go instead.
+static bool map_file(SplitsMap* m, str filename) {
+    File file = file_open(filename, FileRead | FileBinary);
+    if (!file_is_open(file))
+        return false;
+    int64_t size = file_get_length(&file);
+    m->data = size > 0 ? malloc(size) : NULL;
+    if (!m->data || fread(m->data, 1, size, file.ptr) != (size_t)size) {
+        free(m->data);
+        file_close(&file);
+        return false;
+    }
+    m->size = size;
+    file_close(&file);
+    return true;
+}
+
+static void unmap_file(SplitsMap* m) {
+    free(m->data);
+}
+#endif
+
+static uint64_t raw_history_size(uint32_t segment_count, uint32_t attempt_count) {
+    return (uint64_t)attempt_count * (sizeof(Attempt) + segment_count * sizeof(Duration));
+}
+
+// Size of the attempts and column offsets before the encoded columns.
+static uint64_t columns_offset(uint32_t segment_count, uint32_t attempt_count) {
+    return (uint64_t)attempt_count * sizeof(Attempt) + (segment_count + 1) * sizeof(uint64_t);
+}
+
+static uint32_t checksum(const void* data, size_t size) {
+    // FNV-1a
+    const uint8_t* p = data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+static bool in_bounds(SplitsMap* m, uint64_t offset, uint64_t size) {
+    return offset <= m->size && size <= m->size - offset;
+}
+
+static size_t header_size(uint32_t version) {
+    return version >= 4 ? sizeof(SplitsBinHeader) : offsetof(SplitsBinHeader, sketches_offset);
+}
+
+static bool validate(SplitsMap* m) {
+    SplitsBinHeader* h = m->data;
+    if (m->size < header_size(1) || memcmp(h->magic, SPLITS_BIN_MAGIC, sizeof(h->magic)) != 0
+        || h->version < 1 || h->version > SPLITS_BIN_VERSION || m->size < header_size(h->version))
+        return false;
+    if (h->version >= 4
+        && (h->sketches_offset % sizeof(Duration) != 0 || !in_bounds(m, h->sketches_offset, h->sketches_size)))
+        return false;
+    if (h->segments_offset % sizeof(Duration) != 0
+        || !in_bounds(m, h->segments_offset, (uint64_t)h->segment_count * sizeof(SplitsBinSegment))
+        || !in_bounds(m, h->strings_offset, h->strings_size)
+        || !in_bounds(m, h->history_offset, h->history_size)
+        || h->history_offset % sizeof(Duration) != 0
+        || (h->version == 1 && h->history_size != raw_history_size(h->segment_count, h->attempt_count)))
+        return false;
+    if (h->version > 1 && h->attempt_count > 0) {
+        // The columns themselves are checked as they're decoded.
+        uint64_t start = columns_offset(h->segment_count, h->attempt_count);
+        if (h->history_size < start)
+            return false;
+        uint64_t* offsets = (uint64_t*)((char*)m->data + h->history_offset + h->attempt_count * sizeof(Attempt));
+        for (uint32_t i = 0; i < h->segment_count; ++i)
+            if (offsets[i] > offsets[i + 1])
+                return false;
+        if (offsets[0] != 0 || offsets[h->segment_count] > h->history_size - start)
+            return false;
+    }
+    SplitsBinSegment* segments = (SplitsBinSegment*)((char*)m->data + h->segments_offset);
+    const char* strings = (char*)m->data + h->strings_offset;
+    if (h->version >= 3) {
+        const char* game_end = memchr(strings, '\0', h->strings_size);
+        if (!game_end || !memchr(game_end + 1, '\0', strings + h->strings_size - game_end - 1))
+            return false;
+    }
+    for (uint32_t i = 0; i < h->segment_count; ++i) {
+        // Names have to be NUL-terminated in place to be used as-is.
+        if ((uint64_t)segments[i].name_offset + segments[i].name_len >= h->strings_size
+            || strings[segments[i].name_offset + segments[i].name_len] != '\0')
+            return false;
+    }
+    return true;
+}
+
+// Get the update record at `offset` (starting from the end of the body),
+// or NULL at the end of the log or at a torn or corrupt record.
+static SplitsBinUpdate* update_at(SplitsMap* m, uint64_t offset) {
+    if (!in_bounds(m, offset, sizeof(SplitsBinUpdate)))
+        return NULL;
+    SplitsBinUpdate* u = (SplitsBinUpdate*)((char*)m->data + offset);
+    if (u->size % sizeof(Duration) != 0 || !in_bounds(m, offset + sizeof(*u), u->size)
+        || checksum(u + 1, u->size) != u->checksum)
+        return NULL;
+    return u;
+}
+
+static uint64_t body_end(SplitsMap* m) {
+    SplitsBinHeader* h = m->data;
+    uint64_t end = h->history_offset + h->history_size;
+    if (h->version >= 4 && h->sketches_offset + h->sketches_size > end)
+        end = h->sketches_offset + h->sketches_size;
+    return end;
+}
+
+// Read the sketches, returning false if they're missing or corrupt.
+static bool read_sketches(SplitsMap* m, History* h) {
+    SplitsBinHeader* header = m->data;
+    if (header->version < 4 || header->sketches_size == 0)
+        return false;
+    const uint8_t* p = (uint8_t*)m->data + header->sketches_offset;
+    size_t left = header->sketches_size;
+    for (int i = 0; i < h->segment_count; ++i) {
+        size_t size = sketch_decode(&h->sketches[i], p, left);
+        if (size == 0)
+            return false;
+        p += size;
+        left -= size;
+    }
+    return true;
+}
+
+bool splits_is_binary(str filename) {
+    File file = file_open(filename, FileRead | FileBinary);
+    if (!file_is_open(file))
+        return false;
+    char magic[8] = {0};
+    bool is_binary = file_read_u8(&file, (uint8_t*)magic, sizeof(magic)) == sizeof(magic)
+                     && memcmp(magic, SPLITS_BIN_MAGIC, sizeof(magic)) == 0;
+    file_close(&file);
+    return is_binary;
+}
+
+bool splits_map(SplitsMap* m, str filename) {
+    *m = (SplitsMap){0};
+    if (!map_file(m, filename))
+        return false;
+    if (!validate(m)) {
+        unmap_file(m);
+        *m = (SplitsMap){0};
+        return false;
+    }
+
+    SplitsBinHeader* h = m->data;
+    SplitsBinSegment* segments = (SplitsBinSegment*)((char*)m->data + h->segments_offset);
+    char* strings = (char*)m->data + h->strings_offset;
+    if (h->version >= 3) {
+        m->game = (str){.data = strings, .len = strlen(strings)};
+        m->category = (str){.data = strings + m->game.len + 1, .len = strlen(strings + m->game.len + 1)};
+    }
+    // The only allocation: the Splits array itself.
+    m->splits = (Splits){
+        .data = malloc(sizeof(Split) * (h->segment_count + 1)),
+        .len = h->segment_count,
+        .cap = h->segment_count + 1
+    };
+    for (uint32_t i = 0; i < h->segment_count; ++i) {
+        m->splits.data[i] = (Split){
+            .name = {.data = strings + segments[i].name_offset, .len = segments[i].name_len},
+            .time = segments[i].time
+        };
+    }
+
+    SplitsBinUpdate* u;
+    for (uint64_t offset = body_end(m); (u = update_at(m, offset)); offset += sizeof(*u) + u->size) {
+        if (u->type == SplitsUpdateSplit && u->index < h->segment_count && u->size == sizeof(Duration))
+            m->splits.data[u->index].time = *(Duration*)(u + 1);
+    }
+    return true;
+}
+
+bool splits_map_history(SplitsMap* m, History* h) {
+    SplitsBinHeader* header = m->data;
+    history_init(h, header->segment_count);
+    history_reserve(h, header->attempt_count);
+    h->attempt_count = header->attempt_count;
+    // Copied rather than used in place, since the history keeps growing.
+    if (h->attempt_count > 0) {
+        char* block = (char*)m->data + header->history_offset;
+        memcpy(h->attempts, block, sizeof(Attempt) * h->attempt_count);
+        block += sizeof(Attempt) * h->attempt_count;
+        if (header->version == 1) {
+            for (int i = 0; i < h->segment_count; ++i) {
+                memcpy(h->segments[i], block, sizeof(Duration) * h->attempt_count);
+                block += sizeof(Duration) * h->attempt_count;
+            }
+        } else {
+            uint64_t* offsets = (uint64_t*)block;
+            uint8_t* columns = (uint8_t*)(offsets + h->segment_count + 1);
+            for (int i = 0; i < h->segment_count; ++i) {
+                if (!column_decode(columns + offsets[i], offsets[i + 1] - offsets[i],
+                                   h->segments[i], h->attempt_count)) {
+                    history_free(h);
+                    history_init(h, header->segment_count);
+                    return false;
+                }
+            }
+        }
+    }
+    if (!read_sketches(m, h))
+        history_build_sketches(h);
+
+    SplitsBinUpdate* u;
+    for (uint64_t offset = body_end(m); (u = update_at(m, offset)); offset += sizeof(*u) + u->size) {
+        // Attempts can only be appended in order.
+        if (u->type != SplitsUpdateAttempt || u->index != (uint32_t)h->attempt_count
+            || u->size != splits_update_attempt_size(h->segment_count) - sizeof(*u))
+            continue;
+        Attempt* attempt = (Attempt*)(u + 1);
+        history_append(h, *attempt, (Duration*)(attempt + 1));
+    }
+    return true;
+}
+
+void splits_map_summary(SplitsMap* m, int* attempt_count, Duration* pb) {
+    SplitsBinHeader* header = m->data;
+    Attempt* attempts = (Attempt*)((char*)m->data + header->history_offset);
+    *attempt_count = header->attempt_count;
+    *pb = DURATION_NONE;
+    for (uint32_t i = 0; i < header->attempt_count; ++i)
+        if (attempts[i].flags & ATTEMPT_COMPLETED && attempts[i].time < *pb)
+            *pb = attempts[i].time;
+
+    SplitsBinUpdate* u;
+    for (uint64_t offset = body_end(m); (u = update_at(m, offset)); offset += sizeof(*u) + u->size) {
+        if (u->type != SplitsUpdateAttempt || u->index != (uint32_t)*attempt_count
+            || u->size != splits_update_attempt_size(header->segment_count) - sizeof(*u))
+            continue;
+        Attempt* attempt = (Attempt*)(u + 1);
+        if (attempt->flags & ATTEMPT_COMPLETED && attempt->time < *pb)
+            *pb = attempt->time;
+        ++*attempt_count;
+    }
+}
+
+void splits_unmap(SplitsMap* m) {
+    if (!m->data)
+        return;
+    free(m->splits.data);
+    unmap_file(m);
+    *m = (SplitsMap){0};
+}
+
+void* splits_serialize_binary(const SplitsMap* m, History* history, size_t* out_size) {
+    Splits splits = m->splits;
+    size_t strings_size = m->game.len + 1 + m->category.len + 1;
+    for (int i = 0; i < splits.len; ++i)
+        strings_size += splits.data[i].name.len + 1;
+
+    SplitsBinHeader h = {
+        .magic = SPLITS_BIN_MAGIC,
+        .version = SPLITS_BIN_VERSION,
+        .segment_count = splits.len,
+        .segments_offset = sizeof(SplitsBinHeader),
+        .strings_offset = sizeof(SplitsBinHeader) + splits.len * sizeof(SplitsBinSegment),
+        .strings_size = strings_size,
+    };
+    h.history_offset = align8(h.strings_offset + h.strings_size);
+    if (history && history->segment_count == splits.len) {
+        h.attempt_count = history->attempt_count;
+        // Only a bound until the columns are encoded.
+        if (h.attempt_count > 0) {
+            h.history_size = columns_offset(splits.len, h.attempt_count)
+                             + splits.len * column_encoded_bound(h.attempt_count);
+        }
+        for (int i = 0; i < splits.len; ++i)
+            h.sketches_size += sketch_encoded_size(&history->sketches[i]);
+    }
+    h.sketches_offset = h.history_offset + h.history_size;
+
+    size_t size = h.sketches_offset + h.sketches_size;
+    uint8_t* buf = calloc(size, 1);
+    if (!buf)
+        return NULL;
+    memcpy(buf, &h, sizeof(h));
+    SplitsBinSegment* segments = (SplitsBinSegment*)(buf + h.segments_offset);
+    char* strings = (char*)buf + h.strings_offset;
+    memcpy(strings, m->game.data, m->game.len);
+    memcpy(strings + m->game.len + 1, m->category.data, m->category.len);
+    uint32_t offset = m->game.len + 1 + m->category.len + 1;
+    for (int i = 0; i < splits.len; ++i) {
+        str name = splits.data[i].name;
+        segments[i] = (SplitsBinSegment){
+            .name_offset = offset,
+            .name_len = name.len,
+            .time = splits.data[i].time
+        };
+        memcpy(strings + offset, name.data, name.len);
+        offset += name.len + 1;
+    }
+    if (h.attempt_count > 0) {
+        uint8_t* block = buf + h.history_offset;
+        memcpy(block, history->attempts, sizeof(Attempt) * h.attempt_count);
+        uint64_t* offsets = (uint64_t*)(block + sizeof(Attempt) * h.attempt_count);
+        uint8_t* columns = (uint8_t*)(offsets + splits.len + 1);
+        offsets[0] = 0;
+        for (int i = 0; i < splits.len; ++i) {
+            offsets[i + 1] = offsets[i] + column_encode(history->segments[i], h.attempt_count,
+                                                        columns + offsets[i]);
+        }
+        // Shrink to the encoded size, keeping what follows 8-byte aligned.
+        h.history_size = align8(columns_offset(splits.len, h.attempt_count) + offsets[splits.len]);
+        h.sketches_offset = h.history_offset + h.history_size;
+        memcpy(buf, &h, sizeof(h));
+    }
+    if (h.sketches_size > 0) {
+        uint8_t* p = buf + h.sketches_offset;
+        for (int i = 0; i < splits.len; ++i)
+            p += sketch_encode(&history->sketches[i], p);
+    }
+    if (size != h.sketches_offset + h.sketches_size) {
+        size = h.sketches_offset + h.sketches_size;
+        buf = realloc(buf, size);
+    }
+
+    *out_size = size;
+    return buf;
+}
+
+size_t splits_update_split_size(void) {
+    return sizeof(SplitsBinUpdate) + sizeof(Duration);
+}
+
+size_t splits_update_attempt_size(int segment_count) {
+    return sizeof(SplitsBinUpdate) + sizeof(Attempt) + sizeof(Duration) * segment_count;
+}
+
+size_t splits_encode_split_update(void* out, int index, Duration time) {
+    SplitsBinUpdate* u = out;
+    *(Duration*)(u + 1) = time;
+    *u = (SplitsBinUpdate){
+        .type = SplitsUpdateSplit,
+        .size = sizeof(Duration),
+        .index = index,
+        .checksum = checksum(u + 1, sizeof(Duration))
+    };
+    return splits_update_split_size();
+}
+
+size_t splits_encode_attempt_update(void* out, History* h, int attempt) {
+    SplitsBinUpdate* u = out;
+    Attempt* a = (Attempt*)(u + 1);
+    Duration* times = (Duration*)(a + 1);
+    *a = h->attempts[attempt];
+    for (int i = 0; i < h->segment_count; ++i)
+        times[i] = h->segments[i][attempt];
+    size_t size = splits_update_attempt_size(h->segment_count);
+    *u = (SplitsBinUpdate){
+        .type = SplitsUpdateAttempt,
+        .size = size - sizeof(*u),
+        .index = attempt,
+        .checksum = checksum(u + 1, size - sizeof(*u))
+    };
+    return size;
+}
+
+bool splits_save_binary(str filename, const SplitsMap* m, History* history) {
+    size_t size;
+    void* buf = splits_serialize_binary(m, history, &size);
+    if (!buf)
+        return false;
+    bool ok = save_atomic(filename.data, buf, size);
+    free(buf);
+    return ok;
+}
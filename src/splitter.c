@@ -1,8 +1,10 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
+#include <stdlib.h>
 
 #include <fiesta/file.h>
 #include <fiesta/str.h>
@@ -10,227 +12,1077 @@
 
 #include "splitter.h"
 #include "array.h"
+#include "autosave.h"
+#include "clock.h"
+#include "input.h"
+#include "library.h"
+#include "loader.h"
+#include "lss.h"
+#include "saver.h"
+#include "splitsbin.h"
+#include "watcher.h"
 
-// TODO: There might still be some bugs in
-// how these digits of precision are being
-// calculated...
+Split split_create(str name, Duration time) {
+    return (Split){.name = name, .time = time};
+}
 
-double centiseconds(struct timespec ts) {
-    return (double)(ts.tv_nsec) / 10000000000;
+void split_free(Split s) {
+    str_free(s.name);
 }
 
-double deciseconds(struct timespec ts) {
-    return (double)(ts.tv_nsec) / 1000000000;
+_GENERATE_ARRAY_IMPLEMENTATIONS(Split, split)
+
+/* Text .splits files have one split per line: a name, then the split
+   time as seconds and nanoseconds, separated by whitespace. Names with
+   whitespace, quotes or backslashes are written in double quotes, with
+   quotes and backslashes escaped by a backslash, and line breaks written
+   as \n and \r so that each split stays on one line. */
+
+#define TEXT_READ_SIZE (64 * 1024)
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
 }
 
-// 2 digits of precision
-double seconds(struct timespec ts) {
-    return (double)ts.tv_sec + deciseconds(ts) + centiseconds(ts);
+static const char* skip_spaces(const char* p, const char* end) {
+    while (p < end && is_space(*p))
+        ++p;
+    return p;
 }
 
-uint64_t minutes(struct timespec ts) {
-    return (uint64_t)(ts.tv_sec / 60);
+static const char* parse_int(const char* p, const char* end, int64_t* out) {
+    bool negative = p < end && *p == '-';
+    if (negative)
+        ++p;
+    const char* digits = p;
+    int64_t n = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+        n = n * 10 + (*p++ - '0');
+    *out = negative ? -n : n;
+    return p == digits ? NULL : p;
 }
 
-struct timespec delta(struct timespec a, struct timespec b) {
-    return (struct timespec){
-        .tv_sec = abs(a.tv_sec - b.tv_sec),
-        .tv_nsec = abs(a.tv_nsec - b.tv_nsec)
-    };
+// Find the end of the name at `p`, and its length once unescaped.
+static const char* scan_name(const char* p, const char* end, int* len) {
+    const char* start = p;
+    if (*p != '"') {
+        while (p < end && !is_space(*p))
+            ++p;
+        *len = p - start;
+        return p;
+    }
+    *len = 0;
+    for (++p; p < end && *p != '"'; ++p, ++*len) {
+        if (*p == '\\' && ++p == end)
+            return NULL;
+    }
+    return p == end ? NULL : p + 1;
 }
 
-Split split_create(str name, struct timespec time) {
-    return (Split){.name = name, .time = time};
+// Names are appended to one block, which may move as it grows.
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} NameBlock;
+
+// Unescape a name into the block, returning its offset.
+static size_t copy_name(NameBlock* names, const char* p, int len) {
+    if (names->len + len + 1 > names->cap) {
+        while (names->len + len + 1 > names->cap)
+            names->cap *= 2;
+        names->data = realloc(names->data, names->cap);
+    }
+    size_t offset = names->len;
+    char* dst = names->data + offset;
+    if (*p == '"') {
+        ++p;
+        for (int i = 0; i < len; ++i, ++p) {
+            if (*p == '\\') {
+                ++p;
+                dst[i] = *p == 'n' ? '\n' : *p == 'r' ? '\r' : *p;
+            }
+            else
+                dst[i] = *p;
+        }
+    }
+    else
+        memcpy(dst, p, len);
+    dst[len] = '\0';
+    names->len += len + 1;
+    return offset;
 }
 
-void split_free(Split s) {
-    str_free(s.name);
+// Parse one line. Blank and malformed lines are skipped.
+static void parse_line(const char* p, const char* end, Splits* splits, NameBlock* names) {
+    p = skip_spaces(p, end);
+    if (p == end)
+        return;
+    int name_len;
+    const char* q = scan_name(p, end, &name_len);
+    int64_t sec, nsec;
+    if (!q || !(q = parse_int(skip_spaces(q, end), end, &sec))
+           || !(q = parse_int(skip_spaces(q, end), end, &nsec)))
+        return;
+    // Until the block stops moving, names hold their offset into it.
+    size_t offset = copy_name(names, p, name_len);
+    str name = {.data = (char*)(uintptr_t)offset, .len = name_len};
+    splits_append(splits, split_create(name, duration_from_parts(sec, nsec)));
 }
 
-_GENERATE_ARRAY_IMPLEMENTATIONS(Split, split)
+bool splits_load(SplitsMap* m, str filename) {
+    File file = file_open(filename, FileRead | FileBinary);
+    if (!file_is_open(file))
+        return false;
+
+    // Preallocate assuming lines average about 16 bytes,
+    // of which about half is the name.
+    int64_t length = file_get_length(&file);
+    Splits splits = {
+        .cap = length / 16 + DYN_BASE_SIZE,
+        .len = 0
+    };
+    splits.data = malloc(sizeof(Split) * splits.cap);
+    NameBlock names = {.cap = length / 2 + 16};
+    names.data = malloc(names.cap);
 
-Splits splits_load(str filename) {
-    File file = file_open(filename, FileRead);
-    str_arr lines = file_read_lines(&file, 128);
-    Splits splits = splits_create();
-    for (size_t i = 0; i < lines.len; ++i) {
-        str_arr parts = str_split(lines.data[i], ' ');
-        struct timespec ts = {
-            .tv_sec = stoi(parts.data[1]),
-            .tv_nsec = stoi(parts.data[2]),
-        };
-        splits_append(&splits, split_create(STR(parts.data[0].data), ts));
-        str_arr_free(parts);
-    }
-    str_arr_free(lines);
+    // Parse whole lines out of the buffer, then move the partial last
+    // line to the front before reading more. The buffer only grows if
+    // a single line doesn't fit in it.
+    size_t buf_cap = TEXT_READ_SIZE;
+    char* buf = malloc(buf_cap);
+    size_t buf_len = 0;
+    size_t n;
+    do {
+        if (buf_len == buf_cap)
+            buf = realloc(buf, buf_cap *= 2);
+        // fread() directly; file_read_u8() reads one byte per call.
+        n = fread(buf + buf_len, 1, buf_cap - buf_len, file.ptr);
+        buf_len += n;
+
+        const char* p = buf;
+        const char* end = buf + buf_len;
+        const char* nl;
+        while ((nl = memchr(p, '\n', end - p))) {
+            parse_line(p, nl, &splits, &names);
+            p = nl + 1;
+        }
+        // The last line doesn't need a newline.
+        if (n == 0 && p < end) {
+            parse_line(p, end, &splits, &names);
+            p = end;
+        }
+        buf_len = end - p;
+        memmove(buf, p, buf_len);
+    } while (n > 0);
+
+    free(buf);
     file_close(&file);
-    return splits;
+
+    for (int i = 0; i < splits.len; ++i)
+        splits.data[i].name.data = names.data + (uintptr_t)splits.data[i].name.data;
+    *m = (SplitsMap){
+        .data = names.data,
+        .size = names.len,
+        .mapped = false,
+        .splits = splits
+    };
+    return true;
+}
+
+void splits_release(SplitsMap* m) {
+    if (m->data) {
+        splits_unmap(m);
+        return;
+    }
+    splits_free(m->splits);
+    str_free(m->game);
+    str_free(m->category);
+    *m = (SplitsMap){0};
+}
+
+static bool needs_quotes(str name) {
+    if (name.len == 0 || name.data[0] == '"')
+        return true;
+    for (int i = 0; i < name.len; ++i) {
+        if (is_space(name.data[i]) || name.data[i] == '\n' || name.data[i] == '\\')
+            return true;
+    }
+    return false;
 }
 
 void splits_save(str filename, Splits splits) {
     File file = file_open(filename, FileWrite);
     for (size_t i = 0; i < splits.len; ++i) {
         char num_buf[128] = {0};
-        sprintf(num_buf, "%"PRIi64" %"PRIi64, splits.data[i].time.tv_sec, splits.data[i].time.tv_nsec);
+        Duration time = splits.data[i].time;
+        sprintf(num_buf, " %"PRIi64" %"PRIi64"\n", time / NSEC_PER_SEC, time % NSEC_PER_SEC);
 
-        dynstr out = dynstr_create_from(splits.data[i].name.data);
-        dynstr_append_char(&out, ' ');
-        str num_str = str_create_from(num_buf);
-        dynstr_append_str(&out, num_str);
-        dynstr_append_char(&out, '\n');
+        str name = splits.data[i].name;
+        dynstr out = dynstr_create();
+        if (needs_quotes(name)) {
+            dynstr_append_char(&out, '"');
+            for (int j = 0; j < name.len; ++j) {
+                char c = name.data[j];
+                if (c == '"' || c == '\\' || c == '\n' || c == '\r')
+                    dynstr_append_char(&out, '\\');
+                dynstr_append_char(&out, c == '\n' ? 'n' : c == '\r' ? 'r' : c);
+            }
+            dynstr_append_char(&out, '"');
+        }
+        else
+            dynstr_append(&out, name.data);
+        dynstr_append(&out, num_buf);
 
-        file_write_str(&file, dynstr_to_str(&out));
-        str_free(num_str);
+        str line = dynstr_to_str(&out);
+        file_write_str(&file, line);
+        str_free(line);
     }
     file_close(&file);
 }
 
-void timer_start(Timer* t) {
-    clock_gettime(CLOCK_MONOTONIC, &t->start);
-    clock_gettime(CLOCK_MONOTONIC, &t->cur);
+void pause_free(Pause p) {}
+
+_GENERATE_ARRAY_IMPLEMENTATIONS(Pause, pause)
+
+void timer_start(Timer* t, Duration time) {
+    t->start = time;
+    t->cur = time;
+    t->paused = 0;
+    if (!t->pauses.data)
+        t->pauses = pauses_create();
+    t->pauses.len = 0;
     t->running = true;
     t->finished = false;
 }
 
-void timer_stop(Timer* t) {
+void timer_stop(Timer* t, Duration time) {
+    t->cur = time;
     t->running = false;
     t->finished = true;
 }
 
-void timer_toggle_pause(Timer* t) {
+void timer_toggle_pause(Timer* t, Duration time) {
+    if (t->running) {
+        // Freeze the display at the moment of the pause.
+        t->cur = time;
+        pauses_append(&t->pauses, (Pause){.start = time, .end = DURATION_NONE});
+    }
+    else if (timer_paused(t)) {
+        Pause* p = &t->pauses.data[t->pauses.len - 1];
+        p->end = time;
+        t->paused += p->end - p->start;
+        t->cur = time;
+    }
+    else
+        return;
     t->running = !t->running;
 }
 
 void timer_reset(Timer* t) {
-    memset(&t->start, 0, sizeof(struct timespec));
-    memset(&t->cur, 0, sizeof(struct timespec));
+    t->start = 0;
+    t->cur = 0;
+    t->paused = 0;
+    t->pauses.len = 0;
     t->running = false;
     t->finished = false;
 }
 
+void timer_free(Timer* t) {
+    if (t->pauses.data)
+        pauses_free(t->pauses);
+    t->pauses = (Pauses){0};
+}
+
 void timer_update(Timer* t) {
-    clock_gettime(CLOCK_MONOTONIC, &t->cur);
+    t->cur = clock_now();
+}
+
+Duration timer_elapsed_at(Timer* t, Duration time) {
+    return time - t->start - t->paused;
+}
+
+Duration timer_elapsed(Timer* t) {
+    return timer_elapsed_at(t, t->cur);
+}
+
+bool timer_paused(Timer* t) {
+    return !t->running && t->pauses.len > 0 && t->pauses.data[t->pauses.len - 1].end == DURATION_NONE;
+}
+
+bool timer_started(Timer* t) {
+    return t->running || t->finished || timer_paused(t);
+}
+
+bool layout_load(Layout* layout, str filename) {
+    FILE* f = fopen(filename.data, "r");
+    if (!f)
+        return false;
+    Layout loaded = LAYOUT_DEFAULT;
+    char field[64];
+    double value;
+    bool ok = true;
+    int n;
+    while ((n = fscanf(f, "%63s %lf", field, &value)) == 2) {
+        if (strcmp(field, "split_height") == 0)
+            loaded.split_height = value;
+        else if (strcmp(field, "timer_size") == 0)
+            loaded.timer_size = value;
+        else
+            ok = false;
+    }
+    fclose(f);
+    if (!ok || n != EOF)
+        return false;
+    *layout = loaded;
+    return true;
 }
 
 // TODO: These functions will control the timer
 // as well as update visible layout elements,
 // e.g. delta colors.
 
-void splitter_start(SplitterState* ss) {
-    timer_start(&ss->timer);
+static void journal(SplitterState* ss, JournalEventType type, Duration time) {
+    if (ss->journal)
+        journal_append(ss->journal, type, ss->cur_split_index, time);
+}
+
+// What a split shows before the run reaches it.
+static Duration pb_split(SplitterState* ss, int index) {
+    Comparisons* c = &ss->comparisons;
+    if (index >= c->segment_count || c->pb_splits[index] == DURATION_NONE)
+        return 0;
+    return c->pb_splits[index];
 }
 
-void splitter_stop(SplitterState* ss) {
-    timer_stop(&ss->timer);
+static void mark_dirty(SplitterState* ss, int index) {
+    if (ss->autosave)
+        autosave_mark_split(ss->autosave, index);
 }
 
-void splitter_toggle_pause(SplitterState* ss) {
-    timer_toggle_pause(&ss->timer);
+// Estimate the chance of a PB from the run's last split.
+static void update_forecast(SplitterState* ss) {
+    if (!ss->forecast || ss->history.segment_count != ss->splits.len)
+        return;
+    int reached = ss->cur_split_index;
+    Duration time = reached > 0 ? ss->splits.data[reached - 1].time : 0;
+    forecast_start(ss->forecast, &ss->history, reached, time, ss->comparisons.pb);
+}
+
+void splitter_start(SplitterState* ss, Duration time) {
+    timer_start(&ss->timer, time);
+    journal(ss, JournalStart, time);
+}
+
+void splitter_stop(SplitterState* ss, Duration time) {
+    timer_stop(&ss->timer, time);
+    journal(ss, JournalStop, time);
+}
+
+void splitter_toggle_pause(SplitterState* ss, Duration time) {
+    bool was_running = ss->timer.running;
+    timer_toggle_pause(&ss->timer, time);
+    if (ss->timer.running != was_running)
+        journal(ss, was_running ? JournalPause : JournalResume, time);
 }
 
 void splitter_update(SplitterState* ss) {
     timer_update(&ss->timer);
 }
 
-void splitter_split(SplitterState* ss) {
+void splitter_split(SplitterState* ss, Duration time) {
+    if (ss->cur_split_index >= ss->splits.len)
+        return;
+    journal(ss, JournalSplit, time);
     if (ss->cur_split_index + 1 == ss->splits.len)
-        timer_stop(&ss->timer);
-    ss->splits.data[ss->cur_split_index++].time = delta(ss->timer.cur, ss->timer.start);
+        timer_stop(&ss->timer, time);
+    mark_dirty(ss, ss->cur_split_index);
+    Duration elapsed = timer_elapsed_at(&ss->timer, time);
+    ss->splits.data[ss->cur_split_index++].time = elapsed;
+    comparisons_split(&ss->comparisons, elapsed);
+    update_forecast(ss);
+}
+
+void splitter_undo_split(SplitterState* ss) {
+    if (ss->cur_split_index == 0)
+        return;
+    --ss->cur_split_index;
+    ss->splits.data[ss->cur_split_index].time = pb_split(ss, ss->cur_split_index);
+    mark_dirty(ss, ss->cur_split_index);
+    comparisons_undo(&ss->comparisons);
+    update_forecast(ss);
+    if (ss->timer.finished) {
+        ss->timer.finished = false;
+        ss->timer.running = true;
+    }
+    journal(ss, JournalUndo, clock_now());
 }
 
 void splitter_reset(SplitterState* ss) {
+    journal(ss, JournalReset, clock_now());
+    if (timer_started(&ss->timer) && ss->history.segment_count == ss->splits.len) {
+        Duration* times = malloc(sizeof(Duration) * (ss->splits.len + 1));
+        for (int i = 0; i < ss->cur_split_index; ++i)
+            times[i] = ss->splits.data[i].time;
+        history_add(&ss->history, times, ss->cur_split_index, ss->timer.paused);
+        free(times);
+        segment_stats_update(&ss->stats, &ss->history, ss->pool);
+    }
     timer_reset(&ss->timer);
     ss->cur_split_index = 0;
-    // TODO: Load personal best splits instead
-    // of resetting everything.
-    for (size_t i = 0; i < ss->splits.len; ++i)
-        memset(&ss->splits.data[i].time, 0, sizeof(struct timespec));
+    comparisons_reset(&ss->comparisons);
+    splitter_compare_to(ss, ss->compare_stat);
+    for (size_t i = 0; i < ss->splits.len; ++i) {
+        Duration time = pb_split(ss, i);
+        if (ss->splits.data[i].time != time)
+            mark_dirty(ss, i);
+        ss->splits.data[i].time = time;
+    }
+    update_forecast(ss);
+}
+
+void splitter_load_comparisons(SplitterState* ss) {
+    // The splits' own times are the PB without a history, unless
+    // they're the run's.
+    Duration* fallback = NULL;
+    if (!timer_started(&ss->timer)) {
+        fallback = malloc(sizeof(Duration) * (ss->splits.len + 1));
+        for (int i = 0; i < ss->splits.len; ++i)
+            fallback[i] = ss->splits.data[i].time;
+    }
+    comparisons_free(&ss->comparisons);
+    comparisons_init(&ss->comparisons, &ss->history, fallback);
+    free(fallback);
+    segment_stats_compute(&ss->stats, &ss->history, ss->pool);
+    splitter_compare_to(ss, ss->compare_stat);
+    for (int i = 0; i < ss->cur_split_index; ++i)
+        comparisons_split(&ss->comparisons, ss->splits.data[i].time);
+    update_forecast(ss);
+}
+
+void splitter_compare_to(SplitterState* ss, int stat) {
+    ss->compare_stat = stat;
+    if (stat < 0 || ss->stats.segment_count != ss->comparisons.segment_count) {
+        comparisons_compare_to(&ss->comparisons, NULL);
+        return;
+    }
+    Duration* splits = malloc(sizeof(Duration) * (ss->stats.segment_count + 1));
+    segment_stats_splits(&ss->stats, stat, splits);
+    comparisons_compare_to(&ss->comparisons, splits);
+    free(splits);
+}
+
+void splitter_replay(SplitterState* ss, const JournalRecord* records, size_t count) {
+    Journal* journal = ss->journal;
+    ss->journal = NULL;
+    for (size_t i = 0; i < count; ++i) {
+        Duration time = records[i].time;
+        switch (records[i].type) {
+            case JournalStart:  splitter_start(ss, time); break;
+            case JournalSplit:  splitter_split(ss, time); break;
+            case JournalPause:
+            case JournalResume: splitter_toggle_pause(ss, time); break;
+            case JournalStop:   splitter_stop(ss, time); break;
+            case JournalReset:  splitter_reset(ss); break;
+            case JournalUndo:   splitter_undo_split(ss); break;
+        }
+    }
+    ss->journal = journal;
+}
+
+bool splitter_recover(SplitterState* ss) {
+    Journal* j = ss->journal;
+    size_t count = journal_count(j);
+    size_t start = journal_find_run(j);
+    if (start == count)
+        return false;
+
+    // The run's times only mean something on the clock they came from,
+    // and only if that clock hasn't been reset since (e.g. by a reboot).
+    ClockSource prev_clock = clock_selected();
+    if (j->header->clock == ClockVirtual || !clock_select(j->header->clock)
+        || j->records[count - 1].time > clock_now()) {
+        clock_select(prev_clock);
+        // Otherwise a later launch could replay it, once the clock has
+        // passed its times again.
+        journal_append(j, JournalReset, 0, clock_now());
+        return false;
+    }
+
+    splitter_replay(ss, j->records + start, count - start);
+    if (ss->timer.running)
+        splitter_update(ss);
+    return true;
+}
+
+bool splitter_press(SplitterState* ss, InputEvent ev) {
+    switch (ev.key) {
+        case KEY_SPACE: {
+            if (ss->timer.finished)
+                splitter_reset(ss);
+            else if (timer_paused(&ss->timer))
+                splitter_toggle_pause(ss, ev.time);
+            else if (!ss->timer.running)
+                splitter_start(ss, ev.time);
+            else
+                splitter_split(ss, ev.time);
+            return true;
+        }
+        case KEY_P: {
+            if (!ss->timer.finished)
+                splitter_toggle_pause(ss, ev.time);
+            return true;
+        }
+        case KEY_R: {
+            splitter_reset(ss);
+            return true;
+        }
+        case KEY_U: {
+            splitter_undo_split(ss);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Format a time as e.g. "1:02.34", or "-" if it's unknown.
+static void format_time(char* buf, Duration time) {
+    if (time == DURATION_NONE)
+        sprintf(buf, "-");
+    else
+        duration_format(buf, time, 2, 0);
+}
+
+void draw_cache_free(DrawCache* c) {
+    if (c->rows.id != 0)
+        UnloadRenderTexture(c->rows);
+    free(c->splits);
+    *c = (DrawCache){0};
+}
+
+// Whether `t` has to be formatted again to show `value` at font `size`.
+// If so, it's taken to show them from now on.
+static bool text_stale(CachedText* t, Duration value, int size) {
+    if (t->valid && t->value == value && t->size == size)
+        return false;
+    *t = (CachedText){.valid = true, .value = value, .size = size};
+    return true;
+}
+
+static const Color delta_colors[] = {[DeltaGold] = GOLD, [DeltaAhead] = GREEN, [DeltaBehind] = RED};
+
+// Splits shown past the current one while the rows follow the run.
+#define SCROLL_AHEAD 1
+// How quickly the rows scroll: the distance left shrinks by e per
+// 1 / SCROLL_RATE seconds.
+#define SCROLL_RATE 12.0
+
+// The rows that are drawn this frame: `count` of them from `first`,
+// shifted up by `offset` rows while scrolling, then the final split
+// pinned at the bottom if they don't all fit.
+typedef struct {
+    int first;
+    int count;
+    double offset;
+    bool pinned;
+    int rows; // that the list takes up, pinned split included
+} RowWindow;
+
+// Work out which rows fit above the run info and the timer in `height`,
+// scrolling the window towards the current split.
+static RowWindow place_rows(SplitterState* ss, DrawCache* cache, int height) {
+    int len = ss->splits.len;
+    int split_height = ss->layout.split_height > 0 ? ss->layout.split_height : 1;
+    int info_size = split_height / 2;
+    int room = (height - info_size * 6 - ss->layout.timer_size) / split_height;
+    if (room >= len)
+        return (RowWindow){.first = 0, .count = len, .rows = len};
+    if (room < 2)
+        room = 2;
+
+    // Every split but the final one scrolls through `window` rows.
+    int window = room - 1;
+    double max_top = len - 1 - window;
+    if (ss->cur_split_index != cache->followed) {
+        cache->followed = ss->cur_split_index;
+        cache->scrolled = false;
+    }
+    if (!cache->scrolled)
+        cache->target = ss->cur_split_index - (window - 1 - SCROLL_AHEAD);
+    cache->target = fmin(fmax(cache->target, 0), max_top);
+
+    // Without a cache to remember where it was, there's nothing to ease from.
+    if (cache != ss->draw_cache) {
+        cache->top = cache->target;
+    } else {
+        cache->top = fmin(fmax(cache->top, 0), max_top);
+        cache->top += (cache->target - cache->top) * (1 - exp(-GetFrameTime() * SCROLL_RATE));
+        // Stop once it's within a pixel.
+        if (fabs(cache->target - cache->top) * split_height < 1)
+            cache->top = cache->target;
+    }
+
+    RowWindow rw = {.first = floor(cache->top), .pinned = true, .rows = room};
+    rw.offset = cache->top - rw.first;
+    // A row partly scrolled in at the bottom is drawn too.
+    rw.count = window + (rw.offset > 0);
+    if (rw.count > len - 1 - rw.first)
+        rw.count = len - 1 - rw.first;
+    return rw;
+}
+
+// The split shown in the `r`th row of `rw`.
+static inline int row_split(SplitterState* ss, RowWindow rw, int r) {
+    return r < rw.count ? rw.first + r : ss->splits.len - 1;
+}
+
+// Format whatever the rows in `rw` show that changed since the last frame.
+// Returns whether anything did.
+static bool update_rows(SplitterState* ss, DrawCache* cache, RowWindow rw) {
+    bool changed = false;
+    if (cache->split_count != ss->splits.len) {
+        free(cache->splits);
+        cache->splits = calloc(ss->splits.len > 0 ? ss->splits.len : 1, sizeof(SplitText));
+        cache->split_count = ss->splits.len;
+        changed = true;
+    }
+
+    int split_size = ss->layout.split_height;
+    int delta_size = ss->layout.split_height * 0.75;
+    Comparisons* c = &ss->comparisons;
+    for (int r = 0; r < rw.count + rw.pinned; ++r) {
+        int i = row_split(ss, rw, r);
+        Split split = ss->splits.data[i];
+        SplitText* text = &cache->splits[i];
+        if (text->name_data != split.name.data || text->name_len != split.name.len) {
+            text->name_data = split.name.data;
+            text->name_len = split.name.len;
+            snprintf(text->name, sizeof(text->name), "%.*s", (int)split.name.len, split.name.data);
+            changed = true;
+        }
+        if (text_stale(&text->time, split.time, split_size)) {
+            format_time(text->time.text, split.time);
+            text->time.width = MeasureText(text->time.text, split_size);
+            changed = true;
+        }
+        // Deltas against the comparison, in gold for a best segment
+        SplitDelta delta = DeltaHidden;
+        if (i < c->reached && c->deltas[i] != DURATION_NONE) {
+            delta = c->segment_deltas[i] != DURATION_NONE && c->segment_deltas[i] < 0 ? DeltaGold
+                  : c->deltas[i] < 0 ? DeltaAhead : DeltaBehind;
+        }
+        if (delta != text->delta_kind) {
+            text->delta_kind = delta;
+            changed = true;
+        }
+        if (delta != DeltaHidden && text_stale(&text->delta, c->deltas[i], delta_size)) {
+            duration_format(text->delta.text, c->deltas[i], 2, DurationSign | DurationShort);
+            text->delta.width = MeasureText(text->delta.text, delta_size);
+            changed = true;
+        }
+    }
+
+    int info_size = ss->layout.split_height / 2;
+    char time_buf[DURATION_TEXT_SIZE];
+    Duration sum_of_best = comparisons_sum_of_best(c);
+    if (text_stale(&cache->sum_of_best, sum_of_best, info_size)) {
+        format_time(time_buf, sum_of_best);
+        sprintf(cache->sum_of_best.text, "Sum of best: %s", time_buf);
+        changed = true;
+    }
+    if (text_stale(&cache->best_possible, c->best_possible, info_size)) {
+        format_time(time_buf, c->best_possible);
+        sprintf(cache->best_possible.text, "Best possible: %s", time_buf);
+        changed = true;
+    }
+    if (text_stale(&cache->comparing, ss->compare_stat, info_size)) {
+        sprintf(cache->comparing.text, "Comparing to: %s",
+                ss->compare_stat < 0 ? "Personal best" : segment_stat_name(ss->compare_stat));
+        changed = true;
+    }
+    // Shown to a tenth of a percent, so kept in thousandths.
+    double chance;
+    uint64_t samples;
+    Duration permille = ss->forecast && forecast_read(ss->forecast, &chance, &samples)
+                        ? llround(chance * 1000) : DURATION_NONE;
+    if (text_stale(&cache->chance, permille, info_size)) {
+        if (permille == DURATION_NONE)
+            sprintf(cache->chance.text, "Chance to PB: -");
+        else
+            sprintf(cache->chance.text, "Chance to PB: %.1f%%", permille / 10.0);
+        changed = true;
+    }
+    return changed;
+}
+
+// Draw the rows in `rw` and the run info below them, as formatted.
+static void draw_rows(SplitterState* ss, DrawCache* cache, RowWindow rw, int width) {
+    int split_size = ss->layout.split_height;
+    int delta_size = ss->layout.split_height * 0.75;
+    // The pinned split is drawn last, over a row partly scrolled past it.
+    for (int r = 0; r < rw.count + rw.pinned; ++r) {
+        int i = row_split(ss, rw, r);
+        int y_offset = r < rw.count ? lround((r - rw.offset) * split_size) : (rw.rows - 1) * split_size;
+        SplitText* text = &cache->splits[i];
+        DrawRectangle(0, y_offset, width, ss->layout.split_height, i == 0 ? DARKGRAY : GRAY);
+        DrawText(text->name, 10, y_offset, split_size, WHITE);
+        DrawText(text->time.text, width - text->time.width, y_offset, split_size, WHITE);
+        if (text->delta_kind != DeltaHidden) {
+            DrawText(text->delta.text, width - text->time.width - text->delta.width - 10,
+                     y_offset + (split_size - delta_size) / 2, delta_size, delta_colors[text->delta_kind]);
+        }
+    }
+
+    int y_offset = rw.rows * split_size;
+    int info_size = ss->layout.split_height / 2;
+    DrawText(cache->sum_of_best.text, 10, y_offset + info_size / 2, info_size, LIGHTGRAY);
+    DrawText(cache->best_possible.text, 10, y_offset + info_size * 2, info_size, LIGHTGRAY);
+    DrawText(cache->comparing.text, 10, y_offset + info_size * 7 / 2, info_size, LIGHTGRAY);
+    DrawText(cache->chance.text, 10, y_offset + info_size * 5, info_size, LIGHTGRAY);
 }
 
-// very hard-coded
 void splitter_draw(SplitterState ss) {
     int width = GetScreenWidth();
     int height = GetScreenHeight();
-    // Draw splits
-    Color split_color = DARKGRAY;
-    int y_offset = 0;
-    char text_buf[128] = {0};
-    for (size_t i = 0; i < ss.splits.len; ++i) {
-        // Draw background
-        DrawRectangle(0, y_offset, width, ss.layout.split_height, split_color);
-
-        // Draw name
-        sprintf(text_buf, "%s", splits_get(ss.splits, i).name.data);
-        DrawText(text_buf, 10, y_offset, ss.layout.split_height, WHITE);
-        memset(text_buf, 0, sizeof(text_buf));
-
-        // Draw time
-        struct timespec split_time = splits_get(ss.splits, i).time;
-        sprintf(text_buf, "%"PRIu64":%05.2f", minutes(split_time), fmod(seconds(split_time), 60));
-        DrawText(text_buf, width - MeasureText(text_buf, ss.layout.split_height), y_offset, ss.layout.split_height, WHITE);
-        memset(text_buf, 0, sizeof(text_buf));
-
-        y_offset += ss.layout.split_height;
-        split_color = GRAY;
+    // Without a cache, everything is formatted and drawn for just this frame.
+    DrawCache frame_cache = {0};
+    DrawCache* cache = ss.draw_cache ? ss.draw_cache : &frame_cache;
+    // Only the rows that fit are formatted and drawn, however many splits there are.
+    RowWindow rw = place_rows(&ss, cache, height);
+    bool changed = update_rows(&ss, cache, rw);
+    if (cache == &frame_cache) {
+        draw_rows(&ss, cache, rw, width);
+    } else {
+        // The rows only change on a split, undo, reset or reload, while
+        // scrolling, or with the layout or window size, so they're drawn
+        // into a texture then and only copied from it otherwise.
+        if (cache->rows.id == 0 || cache->rows.texture.width != width || cache->rows.texture.height != height) {
+            if (cache->rows.id != 0)
+                UnloadRenderTexture(cache->rows);
+            cache->rows = LoadRenderTexture(width, height);
+            changed = true;
+        }
+        if (changed || cache->top != cache->drawn_top) {
+            BeginTextureMode(cache->rows);
+            ClearBackground(BLACK); // what the window is cleared to
+            draw_rows(&ss, cache, rw, width);
+            EndTextureMode();
+            cache->drawn_top = cache->top;
+        }
+        // Render textures are stored upside down.
+        DrawTextureRec(cache->rows.texture, (Rectangle){0, 0, width, -height}, (Vector2){0, 0}, WHITE);
     }
+
     // Draw timer
-    struct timespec delta_time = delta(ss.timer.cur, ss.timer.start);
-    sprintf(text_buf, "%"PRIu64":%05.2f", minutes(delta_time), fmod(seconds(delta_time), 60));
+    char text_buf[DURATION_TEXT_SIZE];
+    duration_format(text_buf, timer_elapsed(&ss.timer), 2, 0);
     // I'm not sure where the default value of 5.0 comes from for the spacing...
     Vector2 measurements = MeasureTextEx(GetFontDefault(), text_buf, ss.layout.timer_size, 5.0f);
     DrawText(text_buf, width - measurements.x, height - measurements.y, ss.layout.timer_size, WHITE);
+
+    if (cache == &frame_cache)
+        draw_cache_free(&frame_cache);
+}
+
+void splitter_scroll(SplitterState* ss, double rows) {
+    if (!ss->draw_cache)
+        return;
+    // Kept in range when the rows are next placed.
+    ss->draw_cache->target += rows;
+    ss->draw_cache->scrolled = true;
+}
+
+// Swap in newly loaded splits and their history, freeing the old ones.
+// `map` backs the current splits if they were loaded from a file.
+// The run in progress is reset, and saved if autosaving.
+static void swap_splits(SplitterState* ss, SplitsMap* map, SplitsMap new_map, History history, Saver* saver) {
+    if (timer_started(&ss->timer))
+        splitter_reset(ss);
+    if (ss->autosave) {
+        if (autosave_pending(ss->autosave, &ss->history))
+            autosave_flush(ss->autosave, saver, map, &ss->history);
+        autosave_free(ss->autosave);
+        ss->autosave = NULL;
+    }
+    splits_release(map);
+    *map = new_map;
+    ss->splits = map->splits;
+    // The names may be at addresses that the old ones were at.
+    if (ss->draw_cache)
+        draw_cache_free(ss->draw_cache);
+    history_free(&ss->history);
+    ss->history = history;
+    splitter_load_comparisons(ss);
+}
+
+// Publish the history once `loader` has loaded it, and start autosaving.
+static void finish_loading(SplitterState* ss, HistoryLoader* loader, Autosave* autosave, SplitsMap* map, bool wait) {
+    int loaded = history_loader_poll(loader, &ss->history, wait);
+    if (loaded < 0)
+        return;
+    splitter_load_comparisons(ss);
+    autosave_init(autosave, ss->splits.len, loaded, map->size, true);
+    ss->autosave = autosave;
+}
+
+// Whether handling `key` needs the whole history to have been loaded,
+// to save it or to replace it.
+static bool needs_history(int key) {
+    switch (key) {
+        case KEY_S:
+        case KEY_L:
+        case KEY_I:
+        case KEY_LEFT_BRACKET:
+        case KEY_RIGHT_BRACKET:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Load a splits file. Binary files only have their splits loaded up
+// front, and their history is loaded by `loader` in the meantime, so
+// another load has to wait until `loader` is done with `map`.
+static bool load_splits(SplitterState* ss, SplitsMap* map, Saver* saver, HistoryLoader* loader, str filename) {
+    if (loader->active)
+        return false;
+    // Text files are still loaded, for importing.
+    SplitsMap new_map;
+    bool binary = splits_is_binary(filename);
+    bool loaded = binary
+        ? splits_map(&new_map, filename)
+        : splits_load(&new_map, filename);
+    if (!loaded)
+        return false;
+    History history;
+    history_init(&history, new_map.splits.len);
+    swap_splits(ss, map, new_map, history, saver);
+    if (binary)
+        history_loader_start(loader, map);
+    return true;
+}
+
+// Swap in splits that changed on disk, without disturbing the run in
+// progress: its times are kept, and only the names and history change.
+// Returns false if they can't be swapped in yet because the run has a
+// different number of splits.
+static bool reload_splits(SplitterState* ss, SplitsMap* map, Watcher* watcher, HistoryLoader* loader, Autosave* autosave) {
+    int count = watcher_splits_ready(watcher);
+    if (count < 0 || (timer_started(&ss->timer) && count != (int)ss->splits.len))
+        return false;
+    // The old mapping has to stay until its history is loaded.
+    if (loader->active)
+        return false;
+    SplitsMap new_map;
+    History history;
+    if (!watcher_take_splits(watcher, &new_map, &history))
+        return false;
+
+    // The file's contents are what's saved now. What wasn't saved yet
+    // (the run's times, other changed splits and new attempts) is
+    // carried over and saved on top once the autosave knows about it.
+    bool started = timer_started(&ss->timer);
+    bool same = new_map.splits.len == ss->splits.len;
+    int saved_attempts = history.attempt_count;
+    bool* carried = calloc(new_map.splits.len + 1, sizeof(bool));
+    for (size_t i = 0; same && i < ss->splits.len; ++i) {
+        carried[i] = started || (ss->autosave && autosave_split_dirty(ss->autosave, i));
+        if (carried[i])
+            new_map.splits.data[i].time = ss->splits.data[i].time;
+    }
+    if (ss->autosave) {
+        if (autosave_carry_attempts(ss->autosave, &ss->history, &history) < 0)
+            TraceLog(LOG_WARNING, "SPLITTER: Unsaved attempts don't fit the reloaded splits");
+        autosave_free(ss->autosave);
+        ss->autosave = NULL;
+    }
+    splits_release(map);
+    *map = new_map;
+    ss->splits = map->splits;
+    // The names may be at addresses that the old ones were at.
+    if (ss->draw_cache)
+        draw_cache_free(ss->draw_cache);
+    history_free(&ss->history);
+    ss->history = history;
+    splitter_load_comparisons(ss);
+    if (map->mapped) {
+        autosave_init(autosave, ss->splits.len, saved_attempts, map->size, true);
+        ss->autosave = autosave;
+        for (int i = 0; i < (int)ss->splits.len; ++i)
+            if (carried[i])
+                autosave_mark_split(autosave, i);
+    }
+    free(carried);
+    return true;
 }
 
 int main() {
     // TODO: How to make a menu-less window?
     InitWindow(400, 800, "splitter");
-    SetTargetFPS(60);
+    clock_select_best();
+    input_init();
+    double frame_time = 1.0 / 60;
+    double next_frame = GetTime() + frame_time;
 
     SplitterState ss = (SplitterState){
-        .layout = (Layout){
-            .split_height = 40,
-            .timer_size = 50
-        },
+        .layout = LAYOUT_DEFAULT,
         .splits = splits_create_from((Split[]){
-            split_create(STR("One"), (struct timespec){0}),
-            split_create(STR("Two"), (struct timespec){0}),
+            split_create(STR("One"), 0),
+            split_create(STR("Two"), 0),
             (Split){0}
         }),
         .cur_split_index = 0,
         .timer = (Timer){0},
+        .compare_stat = -1,
     };
 
+    // Statistics over big histories are computed on every core.
+    Pool pool;
+    pool_init(&pool, 0);
+    ss.pool = &pool;
+    // So is the chance of a PB, in the background.
+    Forecast forecast;
+    forecast_init(&forecast);
+    ss.forecast = &forecast;
+    // Text is only formatted again when what it shows changes.
+    DrawCache draw_cache = {0};
+    ss.draw_cache = &draw_cache;
+
+    history_init(&ss.history, ss.splits.len);
+    splitter_load_comparisons(&ss);
+
+    // The current splits, along with what backs them once they've been
+    // loaded from a file. `ss.splits` is always `map.splits`.
+    SplitsMap map = {.splits = ss.splits};
+
+    // Every .splits file in the working directory, to switch between.
+    Library library;
+    library_open(&library, STR("."), STR("library.index"));
+    str filename = STR("out.splits");
+
+    // Keeps the splits file up to date once the splits have been
+    // saved to it or loaded from it.
+    Saver saver;
+    saver_init(&saver, filename);
+    Autosave autosave;
+
+    layout_load(&ss.layout, STR("out.layout"));
+
+    // Shows the splits right away, even with a long history.
+    HistoryLoader loader = {0};
+    load_splits(&ss, &map, &saver, &loader, filename);
+
+    // Reloads the splits and the layout when they're edited.
+    Watcher watcher;
+    watcher_start(&watcher, filename, STR("out.layout"), &saver);
+
+    Journal journal;
+    if (journal_open(&journal, STR("out.journal"))) {
+        ss.journal = &journal;
+        if (!splitter_recover(&ss))
+            journal.header->clock = clock_selected();
+    }
+
+    // Keys that need the whole history are held here while it's still
+    // loading, instead of the frame waiting for it.
+    InputEvent held[16];
+    int held_count = 0;
+
+    bool first_frame = true;
     while (!WindowShouldClose()) {
-        switch (GetKeyPressed()) {
-            case KEY_SPACE: {
-                if (ss.timer.finished)
-                    splitter_reset(&ss);
-                else if (!ss.timer.running)
-                    splitter_start(&ss);
-                else
-                    splitter_split(&ss);
-                break;
-            }
-            case KEY_P: {
-                if (!ss.timer.finished)
-                    splitter_toggle_pause(&ss);
-                break;
-            }
-            case KEY_R: {
-                splitter_reset(&ss);
+        finish_loading(&ss, &loader, &autosave, &map, false);
+        int replay = loader.active ? 0 : held_count;
+        if (!loader.active)
+            held_count = 0;
+        InputEvent ev;
+        // Held keys go first, in order; one that starts another load
+        // holds the rest again.
+        for (int h = 0;; ++h) {
+            if (h < replay)
+                ev = held[h];
+            else if (!input_pop(&ev))
                 break;
+            if (splitter_press(&ss, ev))
+                continue;
+            if (loader.active && needs_history(ev.key)) {
+                if (held_count < (int)(sizeof(held) / sizeof(*held)))
+                    held[held_count++] = ev;
+                else
+                    TraceLog(LOG_WARNING, "SPLITTER: Dropped a key while the history loads");
+                continue;
             }
-            case KEY_S: {
-                splits_save(STR("out.splits"), ss.splits);
-                break;
-            }
-            case KEY_L: {
-                if (ss.timer.running)
-                    splitter_reset(&ss);
-                ss.splits = splits_load(STR("out.splits"));
-                break;
+            switch (ev.key) {
+                case KEY_C: {
+                    // Cycle through the PB and then each statistic.
+                    int stat = ss.compare_stat + 1;
+                    splitter_compare_to(&ss, stat < StatCount ? stat : -1);
+                    break;
+                }
+                case KEY_S: {
+                    // Serializing is a memory copy; the disk
+                    // is only touched by the saver's thread.
+                    if (!ss.autosave) {
+                        autosave_init(&autosave, ss.splits.len, ss.history.attempt_count, 0, false);
+                        ss.autosave = &autosave;
+                    }
+                    autosave_mark_all(ss.autosave);
+                    break;
+                }
+                case KEY_E: {
+                    splits_save(STR("out.txt"), ss.splits);
+                    break;
+                }
+                case KEY_L: {
+                    load_splits(&ss, &map, &saver, &loader, filename);
+                    break;
+                }
+                case KEY_LEFT_BRACKET:
+                case KEY_RIGHT_BRACKET: {
+                    // Switch to the previous or next splits in the library.
+                    // Files may have been added, removed or changed since.
+                    library_refresh(&library);
+                    int count = library.listings.len;
+                    if (count == 0)
+                        break;
+                    int i = library_find(&library, filename);
+                    i = i < 0 ? 0 : (i + (ev.key == KEY_LEFT_BRACKET ? count - 1 : 1)) % count;
+                    str next = library.listings.data[i].filename;
+                    if (!load_splits(&ss, &map, &saver, &loader, next))
+                        break;
+                    // Saves of the old splits finish before saving moves on.
+                    // The listing's filename goes at the next refresh.
+                    str_free(filename);
+                    filename = str_create_from(next.data);
+                    saver_close(&saver);
+                    saver_init(&saver, filename);
+                    watcher_stop(&watcher);
+                    watcher_start(&watcher, filename, STR("out.layout"), &saver);
+                    break;
+                }
+                case KEY_I: {
+                    SplitsMap new_map = {0};
+                    History history;
+                    if (lss_import(STR("out.lss"), &new_map, &history))
+                        swap_splits(&ss, &map, new_map, history, &saver);
+                    break;
+                }
+                case KEY_UP:
+                case KEY_DOWN: {
+                    splitter_scroll(&ss, ev.key == KEY_UP ? -1 : 1);
+                    break;
+                }
             }
         }
+        float wheel = GetMouseWheelMove();
+        if (wheel != 0)
+            splitter_scroll(&ss, -wheel);
+
+        reload_splits(&ss, &map, &watcher, &loader, &autosave);
+        watcher_take_layout(&watcher, &ss.layout);
+
+        // Usually only appends the splits and attempts that changed.
+        if (ss.autosave && autosave_pending(ss.autosave, &ss.history))
+            autosave_flush(ss.autosave, &saver, &map, &ss.history);
 
         if (ss.timer.running)
             splitter_update(&ss);
@@ -241,5 +1093,33 @@ int main() {
         splitter_draw(ss);
 
         EndDrawing();
+        if (first_frame) {
+            // GetTime() counts from InitWindow().
+            TraceLog(LOG_INFO, "SPLITTER: First frame after %.1f ms", GetTime() * 1000);
+            first_frame = false;
+        }
+
+        // Pace frames here instead of with SetTargetFPS(), which sleeps
+        // inside EndDrawing() and only polls for input once it's done.
+        while (GetTime() < next_frame)
+            input_wait(next_frame - GetTime());
+        next_frame = fmax(next_frame + frame_time, GetTime());
+    }
+
+    watcher_stop(&watcher);
+    finish_loading(&ss, &loader, &autosave, &map, true);
+    if (ss.autosave) {
+        if (autosave_pending(ss.autosave, &ss.history))
+            autosave_flush(ss.autosave, &saver, &map, &ss.history);
+        autosave_free(ss.autosave);
     }
+    saver_close(&saver);
+    journal_close(&journal);
+    library_free(&library);
+    str_free(filename);
+    timer_free(&ss.timer);
+    draw_cache_free(&draw_cache);
+    forecast_free(&forecast);
+    pool_free(&pool);
+    return 0;
 }
@@ -0,0 +1,266 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "stats.h"
+
+const char* segment_stat_name(SegmentStat stat) {
+    static const char* names[StatCount] = {
+        [StatAverage] = "Average",
+        [StatMedian] = "Median",
+        [StatWorst] = "Worst",
+        [StatLatest] = "Latest",
+        [StatP10] = "10th percentile",
+        [StatP90] = "90th percentile"
+    };
+    return stat >= 0 && stat < StatCount ? names[stat] : "";
+}
+
+void segment_stats_free(SegmentStats* s) {
+    for (int i = 0; i < StatCount; ++i)
+        free(s->values[i]);
+    for (int q = 0; q < QUANTILE_COUNT; ++q)
+        free(s->quantiles[q]);
+    free(s->sums);
+    free(s->counts);
+    *s = (SegmentStats){0};
+}
+
+static void swap(Duration* a, Duration* b) {
+    Duration t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Partially sort `v[lo, hi)` so that v[k] is what it would be if sorted.
+static void select_kth(Duration* v, int lo, int hi, int k) {
+    while (hi - lo > 1) {
+        // Median of three as the pivot, then a Hoare partition.
+        int mid = lo + (hi - 1 - lo) / 2;
+        if (v[mid] < v[lo]) swap(&v[mid], &v[lo]);
+        if (v[hi - 1] < v[lo]) swap(&v[hi - 1], &v[lo]);
+        if (v[hi - 1] < v[mid]) swap(&v[hi - 1], &v[mid]);
+        Duration pivot = v[mid];
+        int i = lo - 1;
+        int j = hi;
+        while (true) {
+            do ++i; while (v[i] < pivot);
+            do --j; while (v[j] > pivot);
+            if (i >= j)
+                break;
+            swap(&v[i], &v[j]);
+        }
+        if (k <= j)
+            hi = j + 1;
+        else
+            lo = j + 1;
+    }
+}
+
+static const SegmentStat quantile_stats[QUANTILE_COUNT] = {StatMedian, StatP10, StatP90};
+static const double quantile_fractions[QUANTILE_COUNT] = {0.5, 0.1, 0.9};
+
+// Rank of each quantile among `count` times.
+static int quantile_rank(int q, int count) {
+    switch (q) {
+        case 0:  return (count - 1) / 2;
+        case 1:  return (count - 1) / 10;
+        default: return (count - 1) - (count - 1) / 10;
+    }
+}
+
+// The loops over whole columns are branchless, so that the compiler can
+// vectorize them. NONE is the largest Duration, so it's never below a
+// time, and never the smallest one above it.
+
+static int count_equal(const Duration* column, int n, Duration value) {
+    int count = 0;
+    for (int a = 0; a < n; ++a)
+        count += column[a] == value;
+    return count;
+}
+
+// Rank all quantiles of a segment in one pass.
+static void count_ranks(const Duration* column, int n, Quantile* q[QUANTILE_COUNT]) {
+    Duration v0 = q[0]->value, v1 = q[1]->value, v2 = q[2]->value;
+    int below0 = 0, below1 = 0, below2 = 0;
+    int equal0 = 0, equal1 = 0, equal2 = 0;
+    for (int a = 0; a < n; ++a) {
+        Duration v = column[a];
+        below0 += v < v0;
+        equal0 += v == v0;
+        below1 += v < v1;
+        equal1 += v == v1;
+        below2 += v < v2;
+        equal2 += v == v2;
+    }
+    *q[0] = (Quantile){.value = v0, .below = below0, .equal = equal0};
+    *q[1] = (Quantile){.value = v1, .below = below1, .equal = equal1};
+    *q[2] = (Quantile){.value = v2, .below = below2, .equal = equal2};
+}
+
+// Move `q` to the next smaller or larger time.
+static void move_down(const Duration* column, int n, Quantile* q) {
+    Duration best = INT64_MIN;
+    for (int a = 0; a < n; ++a) {
+        Duration v = column[a];
+        best = v < q->value && v > best ? v : best;
+    }
+    q->value = best;
+    q->equal = count_equal(column, n, best);
+    q->below -= q->equal;
+}
+
+static void move_up(const Duration* column, int n, Quantile* q) {
+    Duration best = DURATION_NONE;
+    for (int a = 0; a < n; ++a) {
+        Duration v = column[a];
+        best = v > q->value && v < best ? v : best;
+    }
+    q->below += q->equal;
+    q->value = best;
+    q->equal = count_equal(column, n, best);
+}
+
+typedef struct {
+    SegmentStats* stats;
+    History* history;
+} StatsJob;
+
+static void publish(StatsJob* job, int segment, Duration worst, Duration latest) {
+    SegmentStats* s = job->stats;
+    int count = s->counts[segment];
+    s->values[StatAverage][segment] = count ? s->sums[segment] / count : DURATION_NONE;
+    s->values[StatWorst][segment] = count ? worst : DURATION_NONE;
+    s->values[StatLatest][segment] = latest;
+    for (int q = 0; q < QUANTILE_COUNT; ++q) {
+        Duration value = s->sketched ? sketch_quantile(&job->history->sketches[segment], quantile_fractions[q])
+                                     : s->quantiles[q][segment].value;
+        s->values[quantile_stats[q]][segment] = count ? value : DURATION_NONE;
+    }
+}
+
+static void compute_segment(void* arg, int segment) {
+    StatsJob* job = arg;
+    SegmentStats* s = job->stats;
+    const Duration* column = job->history->segments[segment];
+    int n = job->history->attempt_count;
+
+    int64_t sum = 0;
+    int count = 0;
+    Duration worst = INT64_MIN;
+    for (int a = 0; a < n; ++a) {
+        bool present = column[a] != DURATION_NONE;
+        sum += present ? column[a] : 0;
+        count += present;
+        Duration v = present ? column[a] : INT64_MIN;
+        worst = v > worst ? v : worst;
+    }
+    Duration latest = DURATION_NONE;
+    for (int a = n - 1; a >= 0 && latest == DURATION_NONE; --a)
+        latest = column[a];
+    s->sums[segment] = sum;
+    s->counts[segment] = count;
+
+    if (count > 0 && !s->sketched) {
+        // Select on a compacted copy, narrowing the range for each
+        // quantile after the median.
+        // One spare, since NONE entries are written too before being skipped.
+        Duration* v = malloc(sizeof(Duration) * (count + 1));
+        int m = 0;
+        for (int a = 0; a < n; ++a) {
+            v[m] = column[a];
+            m += column[a] != DURATION_NONE;
+        }
+        int k50 = quantile_rank(0, count);
+        int k10 = quantile_rank(1, count);
+        int k90 = quantile_rank(2, count);
+        select_kth(v, 0, count, k50);
+        select_kth(v, 0, k50, k10);
+        select_kth(v, k50 + 1, count, k90);
+        s->quantiles[0][segment].value = v[k50];
+        s->quantiles[1][segment].value = v[k10];
+        s->quantiles[2][segment].value = v[k90];
+        free(v);
+        count_ranks(column, n, (Quantile*[]){
+            &s->quantiles[0][segment], &s->quantiles[1][segment], &s->quantiles[2][segment]});
+    }
+    publish(job, segment, worst, latest);
+}
+
+static void update_segment(void* arg, int segment) {
+    StatsJob* job = arg;
+    SegmentStats* s = job->stats;
+    const Duration* column = job->history->segments[segment];
+    int n = job->history->attempt_count;
+
+    Duration worst = s->values[StatWorst][segment];
+    Duration latest = s->values[StatLatest][segment];
+    for (int a = s->attempt_count; a < n; ++a) {
+        Duration x = column[a];
+        if (x == DURATION_NONE)
+            continue;
+        s->sums[segment] += x;
+        int count = ++s->counts[segment];
+        worst = count == 1 || x > worst ? x : worst;
+        latest = x;
+        for (int q = 0; q < QUANTILE_COUNT && !s->sketched; ++q) {
+            Quantile* quantile = &s->quantiles[q][segment];
+            if (count == 1) {
+                *quantile = (Quantile){.value = x, .below = 0, .equal = 1};
+                continue;
+            }
+            quantile->below += x < quantile->value;
+            quantile->equal += x == quantile->value;
+            int k = quantile_rank(q, count);
+            // The columns include `x` and anything after it, which the
+            // counts don't yet, so only scan up to it.
+            while (k < quantile->below)
+                move_down(column, a + 1, quantile);
+            while (k >= quantile->below + quantile->equal)
+                move_up(column, a + 1, quantile);
+        }
+    }
+    publish(job, segment, worst, latest);
+}
+
+static void allocate(SegmentStats* s, int segment_count) {
+    segment_stats_free(s);
+    int n = segment_count > 0 ? segment_count : 1;
+    s->segment_count = segment_count;
+    for (int i = 0; i < StatCount; ++i)
+        s->values[i] = malloc(sizeof(Duration) * n);
+    for (int q = 0; q < QUANTILE_COUNT; ++q)
+        s->quantiles[q] = calloc(n, sizeof(Quantile));
+    s->sums = calloc(n, sizeof(int64_t));
+    s->counts = calloc(n, sizeof(int));
+}
+
+void segment_stats_compute(SegmentStats* s, History* h, Pool* pool) {
+    if (s->segment_count != h->segment_count || !s->values[0])
+        allocate(s, h->segment_count);
+    s->sketched = h->attempt_count >= STATS_SKETCH_ATTEMPTS;
+    StatsJob job = {.stats = s, .history = h};
+    pool_run(pool, h->segment_count, compute_segment, &job);
+    s->attempt_count = h->attempt_count;
+}
+
+void segment_stats_update(SegmentStats* s, History* h, Pool* pool) {
+    if (s->segment_count != h->segment_count || !s->values[0] || h->attempt_count < s->attempt_count) {
+        segment_stats_compute(s, h, pool);
+        return;
+    }
+    // Once sketched, the exact quantiles are no longer tracked.
+    s->sketched = s->sketched || h->attempt_count >= STATS_SKETCH_ATTEMPTS;
+    StatsJob job = {.stats = s, .history = h};
+    pool_run(pool, h->segment_count, update_segment, &job);
+    s->attempt_count = h->attempt_count;
+}
+
+void segment_stats_splits(SegmentStats* s, SegmentStat stat, Duration* splits) {
+    Duration time = 0;
+    for (int i = 0; i < s->segment_count; ++i) {
+        Duration segment = s->values[stat][i];
+        time = time == DURATION_NONE || segment == DURATION_NONE ? DURATION_NONE : time + segment;
+        splits[i] = time;
+    }
+}
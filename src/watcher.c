@@ -0,0 +1,188 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <raylib.h>
+
+#include "splitsbin.h"
+#include "watcher.h"
+
+// How long the files have to be left alone before they're loaded, so
+// that a file being written in several steps is loaded once, complete.
+#define WATCHER_QUIET_MS 100
+
+#ifndef _WIN32
+static str cstr(char* s) {
+    return (str){.data = s, .len = strlen(s)};
+}
+
+static void load_splits(Watcher* w) {
+    struct stat st;
+    if (stat(w->splits_filename, &st) != 0 || saver_wrote(w->saver, &st))
+        return;
+
+    str filename = cstr(w->splits_filename);
+    SplitsMap map;
+    History history;
+    if (splits_is_binary(filename)) {
+        if (!splits_map(&map, filename))
+            goto fail;
+        if (!splits_map_history(&map, &history)) {
+            history_free(&history);
+            splits_unmap(&map);
+            goto fail;
+        }
+    } else {
+        if (!splits_load(&map, filename))
+            goto fail;
+        history_init(&history, map.splits.len);
+    }
+
+    pthread_mutex_lock(&w->lock);
+    if (w->splits_ready) {
+        splits_release(&w->map);
+        history_free(&w->history);
+    }
+    w->map = map;
+    w->history = history;
+    w->splits_ready = true;
+    pthread_mutex_unlock(&w->lock);
+    return;
+
+fail:
+    TraceLog(LOG_WARNING, "WATCHER: Failed to reload %s", w->splits_filename);
+}
+
+static void load_layout(Watcher* w) {
+    Layout layout;
+    if (!layout_load(&layout, cstr(w->layout_filename))) {
+        TraceLog(LOG_WARNING, "WATCHER: Failed to reload %s", w->layout_filename);
+        return;
+    }
+    pthread_mutex_lock(&w->lock);
+    w->layout = layout;
+    w->layout_ready = true;
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void* watcher_run(void* arg) {
+    Watcher* w = arg;
+    bool splits_changed = false;
+    bool layout_changed = false;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (!__atomic_load_n(&w->stop, __ATOMIC_ACQUIRE)) {
+        // Wake up regularly to check whether to stop.
+        struct pollfd pfd = {.fd = w->fd, .events = POLLIN};
+        if (poll(&pfd, 1, WATCHER_QUIET_MS) <= 0) {
+            if (splits_changed)
+                load_splits(w);
+            if (layout_changed)
+                load_layout(w);
+            splits_changed = layout_changed = false;
+            continue;
+        }
+        ssize_t len = read(w->fd, buf, sizeof(buf));
+        for (char* p = buf; len > 0 && p < buf + len;) {
+            struct inotify_event* ev = (struct inotify_event*)p;
+            if (ev->len > 0 && strcmp(ev->name, w->splits_filename) == 0)
+                splits_changed = true;
+            if (ev->len > 0 && strcmp(ev->name, w->layout_filename) == 0)
+                layout_changed = true;
+            p += sizeof(*ev) + ev->len;
+        }
+    }
+    return NULL;
+}
+
+bool watcher_start(Watcher* w, str splits_filename, str layout_filename, Saver* saver) {
+    *w = (Watcher){
+        .fd = inotify_init1(IN_CLOEXEC),
+        .saver = saver,
+        .splits_filename = strdup(splits_filename.data),
+        .layout_filename = strdup(layout_filename.data)
+    };
+    // The directory is watched rather than the files, since saving
+    // atomically replaces a file instead of writing to it.
+    if (w->fd < 0 || inotify_add_watch(w->fd, ".", IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        if (w->fd >= 0)
+            close(w->fd);
+        free(w->splits_filename);
+        free(w->layout_filename);
+        *w = (Watcher){.fd = -1};
+        return false;
+    }
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_create(&w->thread, NULL, watcher_run, w);
+    return true;
+}
+
+void watcher_stop(Watcher* w) {
+    if (w->fd < 0)
+        return;
+    __atomic_store_n(&w->stop, true, __ATOMIC_RELEASE);
+    pthread_join(w->thread, NULL);
+    close(w->fd);
+    pthread_mutex_destroy(&w->lock);
+    if (w->splits_ready) {
+        splits_release(&w->map);
+        history_free(&w->history);
+    }
+    free(w->splits_filename);
+    free(w->layout_filename);
+    *w = (Watcher){.fd = -1};
+}
+#else
+bool watcher_start(Watcher* w, str splits_filename, str layout_filename, Saver* saver) {
+    (void)splits_filename;
+    (void)layout_filename;
+    (void)saver;
+    *w = (Watcher){.fd = -1};
+    return false;
+}
+
+void watcher_stop(Watcher* w) {
+    (void)w;
+}
+#endif
+
+int watcher_splits_ready(Watcher* w) {
+    if (w->fd < 0)
+        return -1;
+    pthread_mutex_lock(&w->lock);
+    int count = w->splits_ready ? (int)w->map.splits.len : -1;
+    pthread_mutex_unlock(&w->lock);
+    return count;
+}
+
+bool watcher_take_splits(Watcher* w, SplitsMap* map, History* history) {
+    if (w->fd < 0)
+        return false;
+    pthread_mutex_lock(&w->lock);
+    bool ready = w->splits_ready;
+    if (ready) {
+        *map = w->map;
+        *history = w->history;
+        w->splits_ready = false;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ready;
+}
+
+bool watcher_take_layout(Watcher* w, Layout* layout) {
+    if (w->fd < 0)
+        return false;
+    pthread_mutex_lock(&w->lock);
+    bool ready = w->layout_ready;
+    if (ready) {
+        *layout = w->layout;
+        w->layout_ready = false;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ready;
+}
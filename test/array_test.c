@@ -0,0 +1,49 @@
+#include "array.h"
+#include "test.h"
+
+typedef struct {
+    int value;
+} Item;
+
+static void item_free(Item item) {
+    (void)item;
+}
+
+_GENERATE_FUNCTION_PROTOTYPES(Item, item)
+_GENERATE_ARRAY_IMPLEMENTATIONS(Item, item)
+
+#define COUNT 1000
+
+int main(void) {
+    Items items = items_create();
+    for (int i = 0; i < COUNT; ++i)
+        items_append(&items, (Item){i});
+    CHECK(items.len == COUNT && items.cap > COUNT, "len %d, cap %d", items.len, items.cap);
+    for (int i = 0; i < COUNT; ++i)
+        CHECK(items.data[i].value == i, "item %d is %d after growing", i, items.data[i].value);
+
+    // Removing from the front and the back shrinks the array as it goes,
+    // keeping what's left.
+    int front = 0;
+    int back = COUNT - 1;
+    while (items.len > 0) {
+        Item removed = items.len % 2 ? items_remove(&items, items.len - 1) : items_remove(&items, 0);
+        int want = items.len % 2 ? front++ : back--;
+        CHECK(removed.value == want, "removed %d, not %d", removed.value, want);
+        CHECK(items.cap >= DYN_BASE_SIZE && items.cap >= items.len, "len %d, cap %d", items.len, items.cap);
+        CHECK(items.len < 10 || items.cap <= items.len * 3, "len %d, cap %d", items.len, items.cap);
+        for (int i = 0; i < items.len; ++i) {
+            if (items.data[i].value != front + i) {
+                CHECK(false, "item %d is %d with %d left", i, items.data[i].value, items.len);
+                break;
+            }
+        }
+    }
+    CHECK(items.data && items.cap == DYN_BASE_SIZE, "cap %d once empty", items.cap);
+
+    // And it can grow again from empty.
+    items_append(&items, (Item){7});
+    CHECK(items.len == 1 && items.data[0].value == 7, "appending after emptying");
+    items_free(items);
+    return test_report("array");
+}
@@ -0,0 +1,132 @@
+#include <string.h>
+#include <unistd.h>
+
+#include "autosave.h"
+#include "history.h"
+#include "saver.h"
+#include "splitsbin.h"
+#include "splitter.h"
+#include "test.h"
+
+#define PATH     "autosave_test.splits"
+#define SEGMENTS 8
+#define ATTEMPTS 1000
+
+static void add_attempts(History* h, int count) {
+    Duration times[SEGMENTS];
+    for (int a = 0; a < count; ++a) {
+        int n = h->attempt_count;
+        for (int i = 0; i < SEGMENTS; ++i)
+            times[i] = (Duration)(i + 1) * NSEC_PER_MIN + (Duration)n * NSEC_PER_MSEC + i;
+        history_add(h, times, n % 3 ? SEGMENTS : SEGMENTS / 2, n * NSEC_PER_USEC);
+    }
+}
+
+static bool same_bytes(void* a, size_t a_size, void* b, size_t b_size) {
+    return a && b && a_size == b_size && memcmp(a, b, a_size) == 0;
+}
+
+// A snapshot reads the same as the history did when it was taken, even
+// after the history grows (moving its columns) or is freed.
+static void test_snapshot(SplitsMap* m) {
+    History h;
+    history_init(&h, SEGMENTS);
+    add_attempts(&h, ATTEMPTS);
+    size_t size, snapshot_size;
+    void* before = splits_serialize_binary(m, &h, &size);
+
+    History snapshot;
+    history_snapshot(&h, &snapshot);
+    add_attempts(&h, ATTEMPTS * 4);
+    void* after = splits_serialize_binary(m, &snapshot, &snapshot_size);
+    CHECK(same_bytes(before, size, after, snapshot_size), "the snapshot changed as the history grew");
+    free(after);
+    history_release_snapshot(&snapshot);
+
+    // Unpinned again, the history grows in place.
+    add_attempts(&h, ATTEMPTS * 4);
+    CHECK(h.attempt_count == ATTEMPTS * 9 && !h.pin, "%d attempts", h.attempt_count);
+
+    history_snapshot(&h, &snapshot);
+    free(before);
+    before = splits_serialize_binary(m, &h, &size);
+    history_free(&h);
+    after = splits_serialize_binary(m, &snapshot, &snapshot_size);
+    CHECK(same_bytes(before, size, after, snapshot_size), "the snapshot changed once the history was freed");
+    free(after);
+    free(before);
+    history_release_snapshot(&snapshot);
+}
+
+// Whole saves are serialized by the saver, and what it writes loads back.
+static void test_save(SplitsMap* m) {
+    unlink(PATH);
+    History h;
+    history_init(&h, SEGMENTS);
+    add_attempts(&h, ATTEMPTS);
+    Saver saver;
+    saver_init(&saver, STR(PATH));
+    Autosave a;
+    autosave_init(&a, SEGMENTS, 0, 0, false);
+    autosave_flush(&a, &saver, m, &h);
+    // Added while the saver may still be serializing, then appended.
+    add_attempts(&h, 10);
+    autosave_flush(&a, &saver, m, &h);
+    saver_close(&saver);
+    autosave_free(&a);
+
+    SplitsMap loaded;
+    History loaded_history;
+    CHECK(splits_map(&loaded, STR(PATH)), "couldn't map " PATH);
+    CHECK(splits_map_history(&loaded, &loaded_history), "couldn't read the history back");
+    CHECK(loaded_history.attempt_count == h.attempt_count, "%d attempts saved, not %d",
+          loaded_history.attempt_count, h.attempt_count);
+    for (int i = 0; i < SEGMENTS && loaded_history.attempt_count == h.attempt_count; ++i) {
+        CHECK(memcmp(loaded_history.segments[i], h.segments[i], sizeof(Duration) * h.attempt_count) == 0,
+              "segment %d's times", i);
+    }
+    CHECK(loaded.splits.len == SEGMENTS && strcmp(loaded.game.data, "Game") == 0, "the splits");
+    history_free(&loaded_history);
+    splits_release(&loaded);
+    history_free(&h);
+    unlink(PATH);
+}
+
+// Attempts added since the last save are carried over to the history
+// reloaded from the file, and saved on top of it.
+static void test_carry(void) {
+    History h, reloaded;
+    history_init(&h, SEGMENTS);
+    add_attempts(&h, ATTEMPTS);
+    Autosave a;
+    autosave_init(&a, SEGMENTS, ATTEMPTS - 10, 0, true);
+    history_init(&reloaded, SEGMENTS);
+    add_attempts(&reloaded, ATTEMPTS - 10);
+    CHECK(autosave_carry_attempts(&a, &h, &reloaded) == 10, "the unsaved attempts weren't carried");
+    CHECK(reloaded.attempt_count == ATTEMPTS, "%d attempts", reloaded.attempt_count);
+    for (int i = 0; i < SEGMENTS && reloaded.attempt_count == ATTEMPTS; ++i) {
+        CHECK(memcmp(reloaded.segments[i], h.segments[i], sizeof(Duration) * ATTEMPTS) == 0,
+              "segment %d's times", i);
+    }
+    history_free(&reloaded);
+
+    history_init(&reloaded, SEGMENTS - 1);
+    CHECK(autosave_carry_attempts(&a, &h, &reloaded) < 0, "carried attempts to other segments");
+    history_free(&reloaded);
+
+    autosave_mark_split(&a, 3);
+    CHECK(autosave_split_dirty(&a, 3) && !autosave_split_dirty(&a, 2), "the dirty splits");
+    autosave_free(&a);
+    history_free(&h);
+}
+
+int main(void) {
+    SplitsMap m = {.splits = splits_create(), .game = STR("Game"), .category = STR("Any%")};
+    for (int i = 0; i < SEGMENTS; ++i)
+        splits_append(&m.splits, split_create(STR("segment"), (Duration)(i + 1) * NSEC_PER_MIN));
+    test_snapshot(&m);
+    test_save(&m);
+    test_carry();
+    splits_release(&m);
+    return test_report("autosave");
+}
@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bestpath.h"
+#include "comparison.h"
+#include "history.h"
+#include "splitter.h"
+#include "test.h"
+
+#define SEGMENTS 12
+#define ATTEMPTS 300
+#define OFFERS   2000
+
+static uint64_t rng = 0x2545f4914f6cdd1d;
+
+static uint64_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+// The best span between every pair of splits, straight from the history.
+static Duration best[SEGMENTS + 1][SEGMENTS + 1];
+
+static void reference_spans(History* h) {
+    for (int from = 0; from <= SEGMENTS; ++from)
+        for (int to = 0; to <= SEGMENTS; ++to)
+            best[from][to] = DURATION_NONE;
+    for (int a = 0; a < h->attempt_count; ++a) {
+        int last = 0;
+        for (int i = 0; i < SEGMENTS; ++i) {
+            Duration t = history_segment(h, i, a);
+            if (t == DURATION_NONE)
+                continue;
+            if (t < best[last][i + 1])
+                best[last][i + 1] = t;
+            last = i + 1;
+        }
+    }
+}
+
+static void reference_remaining(Duration* remaining) {
+    remaining[SEGMENTS] = 0;
+    for (int k = SEGMENTS - 1; k >= 0; --k) {
+        remaining[k] = DURATION_NONE;
+        for (int to = k + 1; to <= SEGMENTS; ++to) {
+            if (best[k][to] != DURATION_NONE && remaining[to] != DURATION_NONE
+                && best[k][to] + remaining[to] < remaining[k])
+                remaining[k] = best[k][to] + remaining[to];
+        }
+    }
+}
+
+static void check_remaining(BestPaths* p, const char* when) {
+    Duration remaining[SEGMENTS + 1];
+    reference_remaining(remaining);
+    for (int k = 0; k <= SEGMENTS; ++k) {
+        CHECK(best_paths_remaining(p, k) == remaining[k], "%s: from split %d, %lld != %lld",
+              when, k, (long long)best_paths_remaining(p, k), (long long)remaining[k]);
+    }
+}
+
+// `main` frees the zeroed comparisons before computing them the first time.
+static void test_zeroed(void) {
+    Comparisons c = {0};
+    comparisons_free(&c);
+    History h;
+    history_init(&h, 3);
+    comparisons_init(&c, &h, NULL);
+    CHECK(comparisons_sum_of_best(&c) == DURATION_NONE, "no attempts, yet a sum of best");
+    comparisons_free(&c);
+    comparisons_free(&c);
+    comparisons_init(&c, &h, NULL);
+    comparisons_free(&c);
+    history_free(&h);
+
+    SplitterState ss = {0};
+    ss.splits = splits_create();
+    splits_append(&ss.splits, split_create(STR("a"), 5 * NSEC_PER_SEC));
+    splits_append(&ss.splits, split_create(STR("b"), 9 * NSEC_PER_SEC));
+    history_init(&ss.history, ss.splits.len);
+    splitter_load_comparisons(&ss);
+    splitter_load_comparisons(&ss);
+    CHECK(ss.comparisons.pb == 9 * NSEC_PER_SEC, "the splits' times aren't the PB");
+    comparisons_free(&ss.comparisons);
+    segment_stats_free(&ss.stats);
+    history_free(&ss.history);
+    timer_free(&ss.timer);
+    splits_free(ss.splits);
+}
+
+// Random attempts that skip splits now and then, checked against a plain
+// shortest path over every pair of splits.
+static void test_random(void) {
+    History h;
+    history_init(&h, SEGMENTS);
+    Duration times[SEGMENTS];
+    for (int a = 0; a < ATTEMPTS; ++a) {
+        int reached = 1 + next_random() % SEGMENTS;
+        Duration time = 0;
+        for (int i = 0; i < reached; ++i) {
+            time += NSEC_PER_SEC + next_random() % NSEC_PER_SEC;
+            times[i] = i + 1 < reached && next_random() % 5 == 0 ? DURATION_NONE : time;
+        }
+        history_add(&h, times, reached, 0);
+    }
+
+    BestPaths p;
+    best_paths_init(&p, &h);
+    reference_spans(&h);
+    check_remaining(&p, "init");
+    for (int from = 0; from < SEGMENTS; ++from) {
+        for (int to = from + 1; to <= SEGMENTS; ++to) {
+            CHECK(best_paths_span(&p, from, to) == best[from][to], "span %d to %d", from, to);
+        }
+    }
+
+    // Offers and take-backs, as splits and undos make them.
+    for (int i = 0; i < OFFERS; ++i) {
+        int from = next_random() % SEGMENTS;
+        int to = from + 1 + next_random() % (SEGMENTS - from);
+        Duration time = (Duration)(to - from) * NSEC_PER_SEC + next_random() % NSEC_PER_SEC;
+        if (next_random() % 4 == 0) {
+            best_paths_set(&p, from, to, time);
+            best[from][to] = time;
+        } else {
+            bool better = time < best[from][to];
+            CHECK(best_paths_offer(&p, from, to, time) == better, "offer %d to %d", from, to);
+            if (better)
+                best[from][to] = time;
+        }
+        check_remaining(&p, "update");
+    }
+    best_paths_free(&p);
+    history_free(&h);
+}
+
+int main(void) {
+    test_zeroed();
+    test_random();
+    return test_report("bestpath");
+}
@@ -0,0 +1,89 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "duration.h"
+#include "test.h"
+
+// What duration_format has to match, written the obvious way.
+static int reference(char* out, Duration d, int precision, unsigned flags) {
+    uint64_t n = d < 0 ? -(uint64_t)d : (uint64_t)d;
+    const char* sign = d < 0 ? "-" : flags & DurationSign ? "+" : "";
+    uint64_t total_seconds = n / NSEC_PER_SEC;
+    uint64_t hours = total_seconds / 3600;
+    unsigned minutes = total_seconds / 60 % 60;
+    unsigned seconds = total_seconds % 60;
+    int len;
+    if (hours > 0)
+        len = snprintf(out, DURATION_TEXT_SIZE, "%s%" PRIu64 ":%02u:%02u", sign, hours, minutes, seconds);
+    else if (minutes > 0 || !(flags & DurationShort))
+        len = snprintf(out, DURATION_TEXT_SIZE, "%s%u:%02u", sign, minutes, seconds);
+    else
+        len = snprintf(out, DURATION_TEXT_SIZE, "%s%u", sign, seconds);
+    if (precision > 0) {
+        uint64_t fraction = n % NSEC_PER_SEC;
+        for (int i = precision; i < 9; ++i)
+            fraction /= 10;
+        len += snprintf(out + len, DURATION_TEXT_SIZE - len, ".%0*" PRIu64, precision, fraction);
+    }
+    return len;
+}
+
+static uint64_t checked = 0;
+
+static void check(Duration d, int precision, unsigned flags) {
+    char got[DURATION_TEXT_SIZE];
+    char want[DURATION_TEXT_SIZE];
+    size_t len = duration_format(got, d, precision, flags);
+    int want_len = reference(want, d, precision, flags);
+    CHECK(len == (size_t)want_len && strcmp(got, want) == 0, "%" PRId64 " ns at precision %d, flags %u: \"%s\", not \"%s\"",
+          d, precision, flags, got, want);
+    ++checked;
+}
+
+// splitmix64
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+int main(void) {
+    // Every centisecond within 10 hours either way, and the nanosecond
+    // before it, which mustn't round up. The other combinations of flags
+    // only change the start, so an hour either way does for them.
+    for (unsigned flags = 0; flags < 4 && test_failures < 10; ++flags) {
+        Duration range = flags == 0 ? 10 * NSEC_PER_HOUR : NSEC_PER_HOUR + NSEC_PER_MIN;
+        for (Duration d = -range; d <= range; d += NSEC_PER_CSEC) {
+            check(d, 2, flags);
+            check(d - 1, 2, flags);
+        }
+    }
+    // Random times of up to about 12 days, at every precision.
+    uint64_t state = 1;
+    for (int i = 0; i < 1'000'000 && test_failures < 10; ++i) {
+        uint64_t r = next_random(&state);
+        Duration d = (Duration)(r >> 24) * (r & 1 ? -1 : 1);
+        check(d, i % 10, r >> 1 & 3);
+    }
+    Duration edges[] = {0, 1, -1, NSEC_PER_SEC - 1, NSEC_PER_MIN - 1, NSEC_PER_HOUR - 1, NSEC_PER_HOUR,
+                        INT64_MAX, INT64_MIN, INT64_MIN + 1};
+    for (size_t i = 0; i < sizeof(edges) / sizeof(*edges); ++i)
+        for (int precision = 0; precision <= 9; ++precision)
+            for (unsigned flags = 0; flags < 4; ++flags)
+                check(edges[i], precision, flags);
+    // Out of range precisions are clamped.
+    char a[DURATION_TEXT_SIZE];
+    char b[DURATION_TEXT_SIZE];
+    duration_format(a, NSEC_PER_MIN + 1, -3, 0);
+    duration_format(b, NSEC_PER_MIN + 1, 0, 0);
+    CHECK(strcmp(a, b) == 0, "precision -3: \"%s\"", a);
+    duration_format(a, NSEC_PER_MIN + 1, 12, 0);
+    duration_format(b, NSEC_PER_MIN + 1, 9, 0);
+    CHECK(strcmp(a, b) == 0, "precision 12: \"%s\"", a);
+
+    printf("duration: %" PRIu64 " times compared\n", checked);
+    return test_report("duration");
+}
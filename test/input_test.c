@@ -0,0 +1,100 @@
+#include <raylib.h>
+
+#include "clock.h"
+#include "history.h"
+#include "input.h"
+#include "splitter.h"
+#include "test.h"
+
+#define SPLIT_COUNT 5
+// Frames at 60 FPS. Presses land anywhere inside a frame, and are only
+// handled once it ends.
+#define FRAME (NSEC_PER_SEC / 60)
+
+typedef struct {
+    int key;
+    Duration time; // since the clock's start
+} Press;
+
+// A run with a pause, an undo and a split right on a frame's last
+// nanosecond. The clock starts at an odd reading so that nothing lines
+// up with whole frames.
+static const Duration clock_start = 1'234 * NSEC_PER_SEC + 987'654'321;
+static const Press presses[] = {
+    {KEY_SPACE, 5'000'001},                 // start
+    {KEY_SPACE, 61 * NSEC_PER_SEC + 123'457},
+    {KEY_P,     90 * NSEC_PER_SEC + 9'999}, // pause
+    {KEY_P,     95 * NSEC_PER_SEC + 500'001},
+    {KEY_SPACE, 130 * NSEC_PER_SEC + 1},
+    {KEY_SPACE, 131 * NSEC_PER_SEC + 777},
+    {KEY_U,     132 * NSEC_PER_SEC},        // undo
+    {KEY_SPACE, 140 * NSEC_PER_SEC + 42},
+    {KEY_SPACE, 200 * NSEC_PER_SEC + FRAME - 1},
+    {KEY_SPACE, 250 * NSEC_PER_SEC + 333'333},
+};
+#define PRESS_COUNT (sizeof(presses) / sizeof(presses[0]))
+
+// What the splits should read, worked out by hand from the presses.
+static Duration expected(int split) {
+    Duration start = presses[0].time;
+    Duration paused = presses[3].time - presses[2].time;
+    switch (split) {
+        case 0:  return presses[1].time - start;
+        case 1:  return presses[4].time - start - paused;
+        case 2:  return presses[7].time - start - paused; // after the undo
+        case 3:  return presses[8].time - start - paused;
+        default: return presses[9].time - start - paused;
+    }
+}
+
+int main(void) {
+    CHECK(clock_select(ClockVirtual), "no virtual clock");
+    clock_virtual_set(clock_start);
+
+    SplitterState ss = {0};
+    ss.splits = splits_create();
+    const char* names[SPLIT_COUNT] = {"one", "two", "three", "four", "five"};
+    for (int i = 0; i < SPLIT_COUNT; ++i)
+        splits_append(&ss.splits, split_create(STR((char*)names[i]), 0));
+    history_init(&ss.history, SPLIT_COUNT);
+    splitter_load_comparisons(&ss);
+
+    // Run frame by frame: a press is stamped when it arrives (as the key
+    // callback does), then handled when the frame ends.
+    size_t next = 0;
+    Duration frame_end = 0;
+    while (next < PRESS_COUNT) {
+        frame_end += FRAME;
+        for (; next < PRESS_COUNT && presses[next].time < frame_end; ++next) {
+            clock_virtual_set(clock_start + presses[next].time);
+            CHECK(input_push((InputEvent){.key = presses[next].key, .time = clock_now()}),
+                  "input queue full");
+        }
+        clock_virtual_set(clock_start + frame_end);
+        InputEvent ev;
+        while (input_pop(&ev))
+            CHECK(splitter_press(&ss, ev), "key %d not handled", ev.key);
+        if (ss.timer.running)
+            splitter_update(&ss);
+    }
+
+    CHECK(ss.cur_split_index == SPLIT_COUNT, "%d splits reached", ss.cur_split_index);
+    CHECK(ss.timer.finished, "the run didn't finish");
+    // Exact to the nanosecond, so to the microsecond too.
+    for (int i = 0; i < SPLIT_COUNT; ++i) {
+        Duration time = ss.splits.data[i].time;
+        CHECK(time == expected(i), "split %d is %lld ns, pressed at %lld ns (%+lld ns)", i,
+              (long long)time, (long long)expected(i), (long long)(time - expected(i)));
+    }
+    CHECK(timer_elapsed(&ss.timer) == expected(SPLIT_COUNT - 1), "final time %lld ns",
+          (long long)timer_elapsed(&ss.timer));
+    CHECK(ss.timer.paused == presses[3].time - presses[2].time, "paused for %lld ns",
+          (long long)ss.timer.paused);
+
+    comparisons_free(&ss.comparisons);
+    segment_stats_free(&ss.stats);
+    history_free(&ss.history);
+    timer_free(&ss.timer);
+    splits_free(ss.splits);
+    return test_report("input");
+}
@@ -0,0 +1,64 @@
+#include <sched.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "journal.h"
+#include "test.h"
+
+#define PATH "journal_test.journal"
+// Enough to need the file extended a few times.
+#define LONG_RUN (JOURNAL_INITIAL_CAP * 5)
+
+static off_t size_on_disk(void) {
+    struct stat st;
+    return stat(PATH, &st) == 0 ? st.st_size : -1;
+}
+
+int main(void) {
+    unlink(PATH);
+    Journal j;
+    CHECK(journal_open(&j, STR(PATH)), "couldn't create " PATH);
+    off_t initial = size_on_disk();
+
+    // Appending as fast as possible can outrun the thread that extends
+    // the file, in which case the append fails and is tried again. Timer
+    // events come far slower than this.
+    CHECK(journal_append(&j, JournalStart, 0, 0), "appending the start");
+    int retries = 0;
+    for (int i = 1; i < LONG_RUN; ++i) {
+        while (!journal_append(&j, JournalSplit, i, i)) {
+            ++retries;
+            sched_yield();
+        }
+    }
+    CHECK(journal_count(&j) == LONG_RUN, "%zu records", journal_count(&j));
+    CHECK(size_on_disk() > initial, "the file didn't grow");
+    bool ok = true;
+    for (int i = 1; i < LONG_RUN && ok; ++i)
+        ok = j.records[i].type == JournalSplit && j.records[i].time == i;
+    CHECK(ok, "records were lost while the file grew");
+    printf("journal: %d appends retried while the file grew\n", retries);
+
+    // The run in progress is still there when the journal is reopened.
+    journal_close(&j);
+    CHECK(journal_open(&j, STR(PATH)), "couldn't reopen " PATH);
+    CHECK(journal_count(&j) == LONG_RUN && journal_find_run(&j) == 0, "the run wasn't kept");
+
+    // A reset ends it, and the journal starts over...
+    CHECK(journal_append(&j, JournalReset, 0, LONG_RUN), "appending the reset");
+    CHECK(journal_count(&j) == 0, "%zu records after a reset", journal_count(&j));
+    CHECK(journal_append(&j, JournalStart, 0, 1) && journal_append(&j, JournalStop, 0, 2),
+          "appending after a reset");
+    CHECK(journal_count(&j) == 2 && j.records[0].type == JournalStart, "the next run isn't at the front");
+
+    // ...and it shrinks back once there's nothing to recover from it.
+    CHECK(journal_append(&j, JournalReset, 0, 3), "appending the reset");
+    journal_close(&j);
+    CHECK(journal_open(&j, STR(PATH)), "couldn't reopen " PATH);
+    CHECK(size_on_disk() == initial, "%lld bytes, not %lld", (long long)size_on_disk(), (long long)initial);
+    CHECK(journal_count(&j) == 0, "%zu records", journal_count(&j));
+    journal_close(&j);
+    unlink(PATH);
+    return test_report("journal");
+}
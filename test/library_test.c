@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "library.h"
+#include "splitter.h"
+#include "test.h"
+
+#define DIR   "library_test.d"
+#define INDEX DIR "/library.index"
+
+static void save(const char* filename, int split_count) {
+    Splits splits = splits_create();
+    for (int i = 0; i < split_count; ++i)
+        splits_append(&splits, split_create(STR("segment"), (Duration)(i + 1) * NSEC_PER_MIN));
+    splits_save(STR((char*)filename), splits);
+    splits_free(splits);
+}
+
+static bool listed(Library* lib, const char* filename, int split_count) {
+    int i = library_find(lib, STR((char*)filename));
+    return i >= 0 && lib->listings.data[i].segment_count == split_count;
+}
+
+// Files added, changed or removed after the library was opened are
+// picked up when it's refreshed, and the index is written on the way.
+int main(void) {
+    mkdir(DIR, 0755);
+    save(DIR "/a.splits", 2);
+    save(DIR "/b.splits", 3);
+    Library lib;
+    library_open(&lib, STR(DIR), STR(INDEX));
+    CHECK(lib.listings.len == 2 && listed(&lib, DIR "/a.splits", 2) && listed(&lib, DIR "/b.splits", 3),
+          "%d listings", lib.listings.len);
+
+    save(DIR "/c.splits", 4);
+    unlink(DIR "/a.splits");
+    // A different size, in case the mtime doesn't tick.
+    save(DIR "/b.splits", 5);
+    library_refresh(&lib);
+    CHECK(lib.listings.len == 2 && listed(&lib, DIR "/b.splits", 5) && listed(&lib, DIR "/c.splits", 4),
+          "%d listings after the refresh", lib.listings.len);
+    library_free(&lib);
+
+    struct stat st;
+    CHECK(stat(INDEX, &st) == 0 && st.st_size > 0, "the index wasn't written");
+    library_open(&lib, STR(DIR), STR(INDEX));
+    CHECK(lib.listings.len == 2 && listed(&lib, DIR "/c.splits", 4), "%d listings from the index",
+          lib.listings.len);
+    library_free(&lib);
+
+    unlink(DIR "/b.splits");
+    unlink(DIR "/c.splits");
+    unlink(INDEX);
+    rmdir(DIR);
+    return test_report("library");
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "history.h"
+#include "lss.h"
+#include "splitter.h"
+#include "test.h"
+
+#define PATH "lss_test.lss"
+
+// Attempt ids that are sparse and far apart (indexing by id would need
+// gigabytes), segment history times for ids that aren't attempts, and
+// <Segment>s that aren't the run's, and attempts after the segments,
+// which the columns have no room for.
+static const char* lss =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<Run version=\"1.7.0\">\n"
+    "  <GameName>Game</GameName>\n"
+    "  <CategoryName>Any%</CategoryName>\n"
+    "  <Segment><Name>stray</Name></Segment>\n"
+    "  <AttemptHistory>\n"
+    "    <Attempt id=\"-2000000000\" />\n"
+    "    <Attempt id=\"7\"><PauseTime>00:00:02</PauseTime></Attempt>\n"
+    "    <Attempt id=\"2000000000\" />\n"
+    "  </AttemptHistory>\n"
+    "  <Segments>\n"
+    "    <Segment>\n"
+    "      <Name>One</Name>\n"
+    "      <SplitTimes><SplitTime name=\"Personal Best\"><RealTime>00:01:00</RealTime></SplitTime></SplitTimes>\n"
+    "      <SegmentHistory>\n"
+    "        <Time id=\"2000000000\"><RealTime>00:01:03</RealTime></Time>\n"
+    "        <Time id=\"-2000000000\"><RealTime>00:01:01</RealTime></Time>\n"
+    "        <Time id=\"7\"><RealTime>00:01:02</RealTime></Time>\n"
+    "        <Time id=\"-1\"><RealTime>00:00:30</RealTime></Time>\n"
+    "        <Time id=\"8\"><RealTime>00:00:31</RealTime></Time>\n"
+    "      </SegmentHistory>\n"
+    "    </Segment>\n"
+    "    <Other><Segment><Name>nested</Name></Segment></Other>\n"
+    "    <Segment>\n"
+    "      <Name>Tw&#111;&#x20;&#xE9;&#x1F600;&#0;&#xZ;</Name>\n"
+    "      <SplitTimes><SplitTime name=\"Personal Best\"><RealTime>00:02:00</RealTime></SplitTime></SplitTimes>\n"
+    "      <SegmentHistory>\n"
+    "        <Time id=\"7\"><RealTime>00:01:05</RealTime></Time>\n"
+    "      </SegmentHistory>\n"
+    "    </Segment>\n"
+    "  </Segments>\n"
+    "  <Segments><Segment><Name>again</Name></Segment></Segments>\n"
+    "  <AttemptHistory>\n"
+    "    <Attempt id=\"8\"><PauseTime>00:00:09</PauseTime></Attempt>\n"
+    "    <Attempt id=\"9\" />\n"
+    "  </AttemptHistory>\n"
+    "</Run>\n";
+
+int main(void) {
+    FILE* f = fopen(PATH, "wb");
+    fputs(lss, f);
+    fclose(f);
+
+    SplitsMap map;
+    History h;
+    CHECK(lss_import(STR(PATH), &map, &h), "couldn't import " PATH);
+    CHECK(map.splits.len == 2 && h.segment_count == 2, "%d segments", map.splits.len);
+    if (map.splits.len == 2) {
+        CHECK(strcmp(map.splits.data[0].name.data, "One") == 0, "first segment's name");
+        // Character references are decoded to UTF-8, unless they're invalid.
+        CHECK(strcmp(map.splits.data[1].name.data, "Two \xC3\xA9\xF0\x9F\x98\x80&#0;&#xZ;") == 0,
+              "second segment's name: \"%s\"", map.splits.data[1].name.data);
+        CHECK(map.splits.data[1].time == 2 * NSEC_PER_MIN, "PB split time");
+    }
+    CHECK(h.attempt_count == 3, "%d attempts", h.attempt_count);
+    if (h.attempt_count == 3 && h.segment_count == 2) {
+        Duration one[] = {61 * NSEC_PER_SEC, 62 * NSEC_PER_SEC, 63 * NSEC_PER_SEC};
+        Duration two[] = {DURATION_NONE, 65 * NSEC_PER_SEC, DURATION_NONE};
+        for (int a = 0; a < 3; ++a) {
+            CHECK(history_segment(&h, 0, a) == one[a], "segment 0, attempt %d", a);
+            CHECK(history_segment(&h, 1, a) == two[a], "segment 1, attempt %d", a);
+        }
+        CHECK(h.attempts[1].paused == 2 * NSEC_PER_SEC, "attempt 1's pause time");
+        CHECK(h.attempts[1].flags & ATTEMPT_COMPLETED, "attempt 1 isn't completed");
+    }
+    history_free(&h);
+    splits_release(&map);
+    unlink(PATH);
+    return test_report("lss");
+}
@@ -0,0 +1,70 @@
+#include <unistd.h>
+
+#include "clock.h"
+#include "history.h"
+#include "journal.h"
+#include "splitter.h"
+#include "test.h"
+
+#define PATH "recover_test.journal"
+
+static void init_state(SplitterState* ss) {
+    *ss = (SplitterState){0};
+    ss->splits = splits_create();
+    splits_append(&ss->splits, split_create(STR("one"), 0));
+    splits_append(&ss->splits, split_create(STR("two"), 0));
+    history_init(&ss->history, ss->splits.len);
+    splitter_load_comparisons(ss);
+}
+
+static void free_state(SplitterState* ss) {
+    comparisons_free(&ss->comparisons);
+    segment_stats_free(&ss->stats);
+    history_free(&ss->history);
+    timer_free(&ss->timer);
+    splits_free(ss->splits);
+}
+
+// Journal a run that started at `start` and split a second later, then
+// try to recover it.
+static bool recover(Journal* j, Duration start, size_t* left) {
+    j->header->clock = ClockMonotonic;
+    journal_append(j, JournalStart, 0, start);
+    journal_append(j, JournalSplit, 0, start + NSEC_PER_SEC);
+    SplitterState ss;
+    init_state(&ss);
+    ss.journal = j;
+    bool recovered = splitter_recover(&ss);
+    *left = journal_count(j);
+    if (recovered) {
+        CHECK(ss.timer.running && ss.timer.start == start, "the run's start wasn't restored");
+        CHECK(ss.splits.data[0].time == NSEC_PER_SEC, "the split wasn't restored");
+    }
+    free_state(&ss);
+    return recovered;
+}
+
+int main(void) {
+    unlink(PATH);
+    Journal j;
+    CHECK(journal_open(&j, STR(PATH)), "couldn't create " PATH);
+    CHECK(clock_select(ClockMonotonic), "no monotonic clock");
+    size_t left;
+
+    // A run from earlier on the same clock is picked up again.
+    CHECK(recover(&j, clock_now() - 60 * NSEC_PER_SEC, &left), "the run wasn't recovered");
+    CHECK(left == 2, "%zu records after recovering", left);
+    journal_append(&j, JournalReset, 0, clock_now());
+
+    // One whose times are ahead of the clock (e.g. from before a reboot)
+    // isn't, and it's closed so that no later launch picks it up either.
+    CHECK(!recover(&j, clock_now() + 3'600 * NSEC_PER_SEC, &left), "a run from the future was recovered");
+    CHECK(left == 0 && journal_find_run(&j) == journal_count(&j), "the turned down run is still open");
+    journal_close(&j);
+    CHECK(journal_open(&j, STR(PATH)), "couldn't reopen " PATH);
+    CHECK(journal_find_run(&j) == journal_count(&j), "the turned down run is open after reopening");
+
+    journal_close(&j);
+    unlink(PATH);
+    return test_report("recover");
+}
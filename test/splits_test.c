@@ -0,0 +1,45 @@
+#include <string.h>
+#include <unistd.h>
+
+#include "splitter.h"
+#include "test.h"
+
+#define PATH "splits_test.splits"
+
+// Names that need quoting or escaping, or look like they might.
+static const char* names[] = {
+    "plain",
+    "with spaces",
+    "\"quoted\"",
+    "back\\slash",
+    "two\nlines",
+    "crlf\r\nend",
+    "tab\there",
+    "ends with \\",
+    "\\n isn't a newline",
+    "",
+};
+#define NAME_COUNT (sizeof(names) / sizeof(names[0]))
+
+int main(void) {
+    Splits splits = splits_create();
+    for (size_t i = 0; i < NAME_COUNT; ++i) {
+        Duration time = (Duration)(i + 1) * 61 * NSEC_PER_SEC + i * 1'234'567;
+        splits_append(&splits, split_create(STR((char*)names[i]), time));
+    }
+    splits_save(STR(PATH), splits);
+
+    SplitsMap loaded;
+    CHECK(splits_load(&loaded, STR(PATH)), "couldn't load " PATH);
+    CHECK(loaded.splits.len == NAME_COUNT, "%d splits loaded, not %zu", loaded.splits.len, NAME_COUNT);
+    for (int i = 0; i < loaded.splits.len && i < NAME_COUNT; ++i) {
+        str name = loaded.splits.data[i].name;
+        CHECK(name.len == strlen(names[i]) && memcmp(name.data, names[i], name.len) == 0,
+              "split %d is named \"%.*s\"", i, (int)name.len, name.data);
+        CHECK(loaded.splits.data[i].time == splits.data[i].time, "split %d's time", i);
+    }
+    splits_release(&loaded);
+    splits_free(splits);
+    unlink(PATH);
+    return test_report("splits");
+}
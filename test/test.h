@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdio.h>
+
+// Each test program checks as it goes and exits with the number of
+// failed checks, so `make test` stops at the first program that fails.
+static int test_failures = 0;
+
+#define CHECK(cond, ...)                                              \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__,    \
+                    __LINE__, #cond);                                 \
+            fprintf(stderr, __VA_ARGS__);                             \
+            fputc('\n', stderr);                                      \
+            ++test_failures;                                          \
+        }                                                             \
+    } while (0)
+
+static inline int test_report(const char* name) {
+    if (test_failures == 0)
+        printf("%s: ok\n", name);
+    else
+        printf("%s: %d failed\n", name, test_failures);
+    return test_failures != 0;
+}